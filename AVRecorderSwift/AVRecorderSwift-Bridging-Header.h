@@ -10,6 +10,7 @@
 #define AVRecorderSwift_Bridging_Header_h
 
 #import "MotionWrapper.h"
+#import "LiveMotionWrapper.h"
 
 #import "ORSSerialPort.h"
 #import "ORSSerialPortManager.h"
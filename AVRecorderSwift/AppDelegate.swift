@@ -9,21 +9,27 @@
 import Foundation
 import AVFoundation
 
-class AVRecorderDelegate: NSObject, AVCaptureFileOutputRecordingDelegate {
+class AVRecorderDelegate: NSObject, AVCaptureFileOutputRecordingDelegate, AVCaptureVideoDataOutputSampleBufferDelegate {
     
     //set max movie duration, 10 minutes / 600 sec seems ok
     //should not exceed 4GB because of openCV
     //est. 4MB/sec --> max 4000 sec
     let SECONDS : Int64 = 600
     let MAX_MOVIES = 9 // one movie is 10 minutes long, makes the max session duration 90 minutes
+    let REPLAY_SECONDS : Int32 = 20 // length of the instant replay
 
     var device: AVCaptureDevice?
     var deviceInput: AVCaptureDeviceInput?
     var movieFileOutput: AVCaptureMovieFileOutput?
+    var videoDataOutput: AVCaptureVideoDataOutput?
     var session: AVCaptureSession?
     
     var recordingUrl: URL? //here we keep the actual file URL where we are recording
     
+    //live motion tracking for the instant replay, only used on liveQueue
+    let liveQueue = DispatchQueue(label: "ch.pohl.AVRecorderSwift.live", qos: .utility)
+    var liveMotion: LiveMotionWrapper?
+    
     var movieNumber = 0 // the actual movie count
     
     var fileManager = FileManager()
@@ -110,6 +116,16 @@ class AVRecorderDelegate: NSObject, AVCaptureFileOutputRecordingDelegate {
         let preferredTimeScale : Int32 = 1
         let maxDuration : CMTime = CMTimeMake(value: seconds, timescale: preferredTimeScale)
         movieFileOutput!.maxRecordedDuration = maxDuration
+        
+        //add live frames for the instant replay. Late frames are dropped, so the recording is never held up
+        videoDataOutput = AVCaptureVideoDataOutput()
+        videoDataOutput!.videoSettings = [kCVPixelBufferPixelFormatTypeKey as String: kCVPixelFormatType_32BGRA]
+        videoDataOutput!.alwaysDiscardsLateVideoFrames = true
+        videoDataOutput!.setSampleBufferDelegate(self, queue: liveQueue)
+        if session!.canAddOutput(videoDataOutput!) {
+            session!.addOutput(videoDataOutput!)
+            print("live output added to session")
+        }
     }
     
     //MARK: Utility
@@ -138,6 +154,14 @@ class AVRecorderDelegate: NSObject, AVCaptureFileOutputRecordingDelegate {
         
     }
     
+    func makeTimestamp() -> String {
+        let now = Date()
+        let formatter = DateFormatter()
+        formatter.dateFormat = "yyyy-MM-dd' 'HH'-'mm'-'ss"
+        formatter.timeZone = TimeZone(secondsFromGMT: 0)
+        return formatter.string(from: now)
+    }
+    
     //MARK: Control recording
     func startRecording() {
         
@@ -159,11 +183,7 @@ class AVRecorderDelegate: NSObject, AVCaptureFileOutputRecordingDelegate {
         let path : NSString = moviesPath.appendingPathComponent("1_in/") as NSString
         
         //calculate timestamp
-        let now = Date()
-        let formatter = DateFormatter()
-        formatter.dateFormat = "yyyy-MM-dd' 'HH'-'mm'-'ss"
-        formatter.timeZone = TimeZone(secondsFromGMT: 0)
-        let timestamp = formatter.string(from: now)
+        let timestamp = makeTimestamp()
         
         
         // make filename
@@ -172,6 +192,7 @@ class AVRecorderDelegate: NSObject, AVCaptureFileOutputRecordingDelegate {
         let newUrl : URL? = URL(fileURLWithPath: filePathNameExtension as String)
 
         print("recording to file: \(filePathNameExtension)")
+        MotionWrapper.setRecording(true)
         movieFileOutput!.startRecording(to: newUrl!, recordingDelegate: self)
         
         //renaming will be done by fileOutput didFinishRecordingTo
@@ -188,15 +209,62 @@ class AVRecorderDelegate: NSObject, AVCaptureFileOutputRecordingDelegate {
         recordingUrl = nil
         
         session!.stopRunning()
+        MotionWrapper.setRecording(false)
+    }
+    
+    //writes the last REPLAY_SECONDS of the zoomed live picture to 6_replay
+    func saveReplay() {
+        guard let live = liveQueue.sync(execute: { liveMotion }) else {
+            print("no replay available")
+            return
+        }
+        
+        let moviesPath : NSString = NSSearchPathForDirectoriesInDomains(FileManager.SearchPathDirectory.moviesDirectory, FileManager.SearchPathDomainMask.allDomainsMask, true).first! as NSString
+        let path : NSString = moviesPath.appendingPathComponent("6_replay/") as NSString
+        try? fileManager.createDirectory(atPath: path as String, withIntermediateDirectories: true, attributes: nil)
+        
+        let filePathNameExtension = path.appendingPathComponent("\(makeTimestamp()) CAM0 replay.mp4")
+        
+        DispatchQueue.global(qos: DispatchQoS.QoSClass.userInitiated).async {
+            if live.saveReplay(filePathNameExtension) {
+                print("replay saved to file: \(filePathNameExtension)")
+            }
+        }
     }
     
     //MARK: Delegate methods
     
+    func captureOutput(_ output: AVCaptureOutput, didOutput sampleBuffer: CMSampleBuffer, from connection: AVCaptureConnection) {
+        guard let pixelBuffer = CMSampleBufferGetImageBuffer(sampleBuffer) else {
+            return
+        }
+        
+        //the engine is set up with the first frame, as only then the size is known
+        if liveMotion == nil {
+            let moviesPath : NSString = NSSearchPathForDirectoriesInDomains(FileManager.SearchPathDirectory.moviesDirectory, FileManager.SearchPathDomainMask.allDomainsMask, true).first! as NSString
+            let maskFileName = moviesPath.appendingPathComponent("0_mask/horseSampleShotMask.png")
+            
+            var fps = 25.0
+            if let frameDuration = device?.activeVideoMinFrameDuration, frameDuration.isValid, frameDuration.seconds > 0 {
+                fps = 1.0 / frameDuration.seconds
+            }
+            
+            liveMotion = LiveMotionWrapper(width: Int32(CVPixelBufferGetWidth(pixelBuffer)), height: Int32(CVPixelBufferGetHeight(pixelBuffer)), fps: fps, replaySeconds: REPLAY_SECONDS, maskFileName: maskFileName)
+        }
+        
+        //the capture time, so dropped frames do not make the replay play too fast
+        let timestamp = CMSampleBufferGetPresentationTimeStamp(sampleBuffer).seconds
+        liveMotion!.process(pixelBuffer, timestamp: timestamp)
+    }
+    
     func fileOutput(_ output: AVCaptureFileOutput, didFinishRecordingTo outputFileURL: URL, from connections: [AVCaptureConnection], error: Error?) {
         print("finished recording", outputFileURL.lastPathComponent)
         if (error.debugDescription.contains("Code=-11810")) {
             // has been finished because movie file has reached intended size --> restart
             startRecording()
+        } else {
+            //stopped or failed, the motion processing may use the whole machine again
+            MotionWrapper.setRecording(false)
         }
         renameFileDone(outputFileURL)
     }
@@ -0,0 +1,142 @@
+//
+//  DebugSink.cpp
+//  AVRecorderSwift
+//
+//  Created by Andreas Pohl on 19.10.26.
+//  Copyright © 2026 Andreas Pohl. All rights reserved.
+//
+
+#include "DebugSink.hpp"
+#include "ResourceGovernor.hpp"
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+
+//max frames waiting for rendering. If the renderer falls behind, the pipeline waits for it
+//no frame is dropped, so the debug movie stays in step with the processed output frame by frame
+const size_t MAX_QUEUED_FRAMES = 50;
+
+DebugSink::DebugSink(string inFileNameBase, OutputType type, double inFps) {
+    fileNameBase = inFileNameBase;
+    outputType = type;
+    fps = inFps > 0 ? inFps : 25;
+    worker = thread(&DebugSink::run, this);
+}
+
+//renders all remaining frames before returning
+DebugSink::~DebugSink() {
+    {
+        lock_guard<mutex> lock(queueMutex);
+        stopping = true;
+    }
+    queueCondition.notify_one();
+    worker.join();
+    outVideo.release();
+    
+    if (waitCount > 0) {
+        cout << "DebugSink made the processing wait " << waitCount << " times in " << frameCount << " frames\n";
+    }
+}
+
+//hand over the overlay of one frame, only blocks while MAX_QUEUED_FRAMES are waiting for rendering
+void DebugSink::push(Overlay &&overlay) {
+    {
+        unique_lock<mutex> lock(queueMutex);
+        if (queue.size() >= MAX_QUEUED_FRAMES) {
+            waitCount++;
+            spaceCondition.wait(lock, [this] { return queue.size() < MAX_QUEUED_FRAMES; });
+        }
+        queue.push_back(std::move(overlay));
+    }
+    queueCondition.notify_one();
+}
+
+void DebugSink::run() {
+    Mat out;
+    while (true) {
+        Overlay overlay;
+        {
+            unique_lock<mutex> lock(queueMutex);
+            queueCondition.wait(lock, [this] { return stopping or !queue.empty(); });
+            if (queue.empty()) {
+                return; //stopping and everything rendered
+            }
+            overlay = std::move(queue.front());
+            queue.pop_front();
+        }
+        spaceCondition.notify_one();
+        
+        //runs beside the processing, OpenCV's thread pool must stay as it is meanwhile
+        ResourceGovernor::OpenCvScope openCvScope;
+        render(overlay, out);
+        write(out);
+    }
+}
+
+//draws the overlay into the frame and puts the zoomed image beside it
+void DebugSink::render(Overlay &overlay, Mat &out) {
+    Mat &redFrame = overlay.frame;
+    if (redFrame.channels() == 1) {
+        cvtColor(redFrame, redFrame, COLOR_GRAY2BGR);
+    }
+    
+    //draw analysed regions
+    for (auto r = overlay.regions.begin(); r != overlay.regions.end(); ++r) {
+        rectangle(redFrame, r->tl(), r->br(), Scalar(0, 255, 0), 1);
+    }
+    
+    //draw circles around objects
+    for (auto obj = overlay.objects.begin(); obj != overlay.objects.end(); ++obj) {
+        circle(redFrame, *obj, 30, Scalar(0, 0, 255), FILLED, LINE_AA);
+    }
+    
+    //draw circles around the cluster centers
+    for (auto c = overlay.centers.begin(); c != overlay.centers.end(); ++c) {
+        circle(redFrame, *c, 60, Scalar(255, 0, 255), 1, LINE_AA);
+    }
+    
+    //draw sample points (non zero points)
+    for (auto p = overlay.samplePoints.begin(); p != overlay.samplePoints.end(); ++p) {
+        circle(redFrame, *p, 1, Scalar(255, 255, 0), FILLED, LINE_AA);
+    }
+    
+    //draw center of camera (after inertia filtering)
+    Point c = overlay.zoomCenter;
+    line(redFrame, Point(c.x, c.y + 25), Point(c.x, c.y - 25), Scalar(255, 255, 0), 3);
+    line(redFrame, Point(c.x + 25, c.y), Point(c.x - 25, c.y), Scalar(255, 255, 0), 3);
+    
+    //draw bounding rectangle
+    rectangle(redFrame, overlay.boundingRectangle.tl(), overlay.boundingRectangle.br(), Scalar(0, 255, 255), 3);
+    
+    //draw zoom rectangle
+    rectangle(redFrame, overlay.zoomRectangle.tl(), overlay.zoomRectangle.br(), Scalar(255, 200, 0), 3);
+    
+    //side by side: analysed frame | zoomed output scaled to the same height
+    Mat zoomed;
+    if (overlay.zoomedImage.empty()) {
+        zoomed = Mat::zeros(redFrame.size(), redFrame.type());
+    } else {
+        double scale = (double) redFrame.rows / overlay.zoomedImage.rows;
+        resize(overlay.zoomedImage, zoomed, Size(), scale, scale, INTER_AREA);
+    }
+    hconcat(redFrame, zoomed, out);
+}
+
+void DebugSink::write(Mat &image) {
+    if (outputType == OutputType::IMAGES) {
+        std::stringstream ss;
+        ss << fileNameBase << " " << std::setw(5) << std::setfill('0') << frameCount << ".jpg";
+        imwrite(ss.str(), image);
+    } else {
+        if (frameCount == 0) {
+            string fileName = fileNameBase + ".mov";
+            outVideo.open(fileName, outVideo.fourcc('m', 'p', '4', 'v'), fps, image.size(), true);
+            if (!outVideo.isOpened()) {
+                cout << "ERROR OPENING DEBUG STREAM\n";
+            }
+        }
+        outVideo.write(image);
+    }
+    frameCount++;
+}
@@ -0,0 +1,74 @@
+//
+//  DebugSink.hpp
+//  AVRecorderSwift
+//
+//  Created by Andreas Pohl on 19.10.26.
+//  Copyright © 2026 Andreas Pohl. All rights reserved.
+//
+
+#ifndef DebugSink_hpp
+#define DebugSink_hpp
+
+#include <stdio.h>
+
+#include <opencv2/opencv.hpp>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace cv;
+
+//renders the debug overlays of the motion tracking on a background thread,
+//so debug runs are nearly as fast as production runs and need no display
+class DebugSink {
+    
+public:
+    enum class OutputType {
+        VIDEO, // one side by side movie: analysed frame with overlays | zoomed output
+        IMAGES // the same side by side frames as numbered jpg files
+    };
+    
+    //the drawing primitives of one frame, all coordinates in the reduced frame
+    struct Overlay {
+        Mat frame; // reduced input frame, must not be shared with the pipeline
+        Mat zoomedImage; // zoomed output frame, must not be shared with the pipeline
+        vector<Point2f> objects; // tracked objects
+        vector<Point2f> centers; // cluster centers
+        vector<Point> samplePoints; // non zero points of the threshold image
+        vector<Rect> regions; // analysed regions
+        Rect boundingRectangle = Rect(0, 0, 0, 0);
+        Rect zoomRectangle = Rect(0, 0, 0, 0);
+        Point zoomCenter = Point(0, 0);
+    };
+    
+    DebugSink(string fileNameBase, OutputType type, double fps);
+    ~DebugSink();
+    void push(Overlay &&overlay);
+    
+private:
+    string fileNameBase;
+    OutputType outputType;
+    double fps;
+    
+    VideoWriter outVideo;
+    int frameCount = 0;
+    int waitCount = 0;
+    
+    deque<Overlay> queue;
+    mutex queueMutex;
+    condition_variable queueCondition;
+    condition_variable spaceCondition;
+    bool stopping = false;
+    thread worker;
+    
+    void run();
+    void render(Overlay &overlay, Mat &out);
+    void write(Mat &image);
+};
+
+#endif /* DebugSink_hpp */
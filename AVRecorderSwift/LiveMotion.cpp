@@ -0,0 +1,49 @@
+//
+//  LiveMotion.cpp
+//  AVRecorderSwift
+//
+//  Created by Andreas Pohl on 19.10.26.
+//  Copyright © 2026 Andreas Pohl. All rights reserved.
+//
+
+#include "LiveMotion.hpp"
+#include "ResourceGovernor.hpp"
+
+//size of the replay, the same as the processed output
+const Size REPLAY_VIDEO_SIZE = Size(1280, 720);
+
+LiveMotion::LiveMotion(int width, int height, double fps, int replaySeconds) :
+    engine(width, height),
+    replay(REPLAY_VIDEO_SIZE.width, REPLAY_VIDEO_SIZE.height, fps, replaySeconds) {
+}
+
+void LiveMotion::setMask(const Mat &mask) {
+    engine.setMask(mask);
+}
+
+//track, cut out the zoom window of the caller's buffer and keep it encoded in the replay buffer
+void LiveMotion::process(const MotionEngine::Frame &frame, double timestamp) {
+    //the engine only tracks frames of the size it was created with, others are skipped
+    if (Size(frame.width, frame.height) != engine.getInputSize()) {
+        return;
+    }
+    //runs on the capture queue, OpenCV's thread pool must stay as it is meanwhile
+    ResourceGovernor::OpenCvScope openCvScope;
+    MotionEngine::Result result = engine.process(frame);
+    
+    int type = frame.format == MotionEngine::PixelFormat::BGRA ? CV_8UC4 : CV_8UC3;
+    if (frame.format == MotionEngine::PixelFormat::GRAY) {
+        type = CV_8UC1;
+    }
+    Mat in(frame.height, frame.width, type, (void *) frame.data, frame.stride);
+    resize(in(result.crop), zoomedImage, REPLAY_VIDEO_SIZE, 0, 0, INTER_LINEAR);
+    if (zoomedImage.channels() == 1) {
+        cvtColor(zoomedImage, zoomedImage, COLOR_GRAY2BGR);
+    }
+    
+    replay.push(zoomedImage, timestamp);
+}
+
+bool LiveMotion::saveReplay(const string &fileName) {
+    return replay.save(fileName);
+}
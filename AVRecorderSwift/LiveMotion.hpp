@@ -0,0 +1,41 @@
+//
+//  LiveMotion.hpp
+//  AVRecorderSwift
+//
+//  Created by Andreas Pohl on 19.10.26.
+//  Copyright © 2026 Andreas Pohl. All rights reserved.
+//
+
+#ifndef LiveMotion_hpp
+#define LiveMotion_hpp
+
+#include <stdio.h>
+
+#include "MotionEngine.hpp"
+#include "ReplayBuffer.hpp"
+
+#include <opencv2/opencv.hpp>
+
+#include <string>
+
+using namespace std;
+using namespace cv;
+
+//motion tracking on the live camera frames, feeding the instant replay with the zoomed output
+class LiveMotion {
+    
+public:
+    LiveMotion(int width, int height, double fps, int replaySeconds);
+    
+    void setMask(const Mat &mask);
+    //timestamp: presentation time of the frame in seconds
+    void process(const MotionEngine::Frame &frame, double timestamp);
+    bool saveReplay(const string &fileName);
+    
+private:
+    MotionEngine engine;
+    ReplayBuffer replay;
+    Mat zoomedImage;
+};
+
+#endif /* LiveMotion_hpp */
@@ -0,0 +1,18 @@
+//
+//  LiveMotionWrapper.h
+//  AVRecorderSwift
+//
+//  Created by Andreas Pohl on 19.10.26.
+//  Copyright © 2026 Andreas Pohl. All rights reserved.
+//
+
+#pragma once
+
+#import <Foundation/Foundation.h>
+#import <CoreVideo/CoreVideo.h>
+@interface LiveMotionWrapper : NSObject
+- (instancetype)initWithWidth:(int)width height:(int)height fps:(double)fps replaySeconds:(int)replaySeconds maskFileName:(NSString *)maskFileName;
+//timestamp: presentation time of the frame in seconds
+- (void)processPixelBuffer:(CVPixelBufferRef)pixelBuffer timestamp:(double)timestamp NS_SWIFT_NAME(process(_:timestamp:));
+- (BOOL)saveReplay:(NSString *)fileName;
+@end
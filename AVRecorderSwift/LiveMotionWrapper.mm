@@ -0,0 +1,53 @@
+//
+//  LiveMotionWrapper.mm
+//  AVRecorderSwift
+//
+//  Created by Andreas Pohl on 19.10.26.
+//  Copyright © 2026 Andreas Pohl. All rights reserved.
+//
+
+//OpenCV has to come before the Apple headers, its stitching module clashes with the NO macro
+#include "LiveMotion.hpp"
+#import "LiveMotionWrapper.h"
+
+#include <memory>
+
+@implementation LiveMotionWrapper {
+    std::unique_ptr<LiveMotion> live;
+}
+
+- (instancetype)initWithWidth:(int)width height:(int)height fps:(double)fps replaySeconds:(int)replaySeconds maskFileName:(NSString *)maskFileName {
+    self = [super init];
+    if (self) {
+        live.reset(new LiveMotion(width, height, fps, replaySeconds));
+        cv::Mat mask = cv::imread([maskFileName cStringUsingEncoding:NSUTF8StringEncoding], cv::IMREAD_GRAYSCALE);
+        if (!mask.data) {
+            NSLog(@"NO MASK IMAGE FOUND");
+        }
+        live->setMask(mask);
+    }
+    return self;
+}
+
+//the pixel buffer is read in place, it has to be kCVPixelFormatType_32BGRA
+- (void)processPixelBuffer:(CVPixelBufferRef)pixelBuffer timestamp:(double)timestamp {
+    if (CVPixelBufferGetPixelFormatType(pixelBuffer) != kCVPixelFormatType_32BGRA) {
+        return;
+    }
+    CVPixelBufferLockBaseAddress(pixelBuffer, kCVPixelBufferLock_ReadOnly);
+    
+    MotionEngine::Frame frame;
+    frame.data = (const unsigned char *) CVPixelBufferGetBaseAddress(pixelBuffer);
+    frame.width = (int) CVPixelBufferGetWidth(pixelBuffer);
+    frame.height = (int) CVPixelBufferGetHeight(pixelBuffer);
+    frame.stride = CVPixelBufferGetBytesPerRow(pixelBuffer);
+    frame.format = MotionEngine::PixelFormat::BGRA;
+    live->process(frame, timestamp);
+    
+    CVPixelBufferUnlockBaseAddress(pixelBuffer, kCVPixelBufferLock_ReadOnly);
+}
+
+- (BOOL)saveReplay:(NSString *)fileName {
+    return live->saveReplay([fileName cStringUsingEncoding:NSUTF8StringEncoding]) ? YES : NO;
+}
+@end
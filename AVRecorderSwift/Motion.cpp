@@ -21,8 +21,10 @@
 //0.3 trying to record and store to file
 
 #include "Motion.hpp"
-#include "Filter.hpp"
-#include "ObjectHandler.hpp"
+#include "MotionEngine.hpp"
+#include "MotionVectorReader.hpp"
+#include "DebugSink.hpp"
+#include "ResourceGovernor.hpp"
 
 #include <opencv2/imgcodecs.hpp>
 #include <opencv2/videoio/videoio.hpp>
@@ -33,43 +35,37 @@
 #include <fstream>
 #include <stdio.h>
 #include <iomanip>
+#include <memory>
+#include <sys/stat.h>
 
 #include <dispatch/dispatch.h>
 
 using namespace std;
 using namespace cv;
 
-//our sensitivity value to be used in the threshold() function
-const static int SENSITIVITY_VALUE = 30; //was 20 initially
-//size of blur used to smooth the intensity image output from absdiff() function
-const static int BLUR_SIZE = 10;
-//we'll have just one object to search for and keep track of its position.
-int theObject[2] = { 0, 0 };
-//bounding rectangle of the object, we will use the center of this as its position.
-Rect objectBoundingRectangle = Rect(0, 0, 0, 0);
-//filtered object position;
-Point2f filteredPosition;
-
 //input video size
 const Size IN_VIDEO_SIZE = Size(1920, 1080);
 
 //output video size. For movies from Lumix, this is also the input video size.
 const Size OUT_VIDEO_SIZE = Size(1280, 720);
 
-//max zoom window
-Size MAX_ZOOMED_WINDOW = Size(640, 360);
-
-//factor for reducing the frames for speed
-const static double reduceFactor = 0.5;
-
-//bezel, free room between object and zoomed window
-const int BEZEL = 100 * reduceFactor;
-
 //max frames per file, estimated to not exceed the opencv 4GB file size limit
 //further limited to make short output movies, as VideoWriter slows down extremely with larger file size
 //250 frames at 25 fps --> 10 sec.
 const static int MAX_FRAMES = 125;
 
+//a camera may cover several areas, each one gets its own mask, tracking and output movie
+//masks: horseSampleShotMask.png, horseSampleShotMask 2.png, horseSampleShotMask 3.png, ...
+const static int MAX_AREAS = 8;
+
+//between full frame sweeps, only the regions around the predicted positions of the tracked objects are analysed
+//off by default, until the zoom is checked against full tracking on the test movies (MotionTest testMotionRoiTracking)
+static bool roiTracking = false;
+
+//how a full sweep looks for motion
+//FULL until the output of the other modes is checked against it on the test movies
+static Motion::SweepMode sweepMode = Motion::SweepMode::FULL;
+
 //int to string helper function
 string intToString(int number) {
     
@@ -81,9 +77,21 @@ string intToString(int number) {
 
 //for testing
 static bool test = false;
+static DebugSink::OutputType debugOutputType = DebugSink::OutputType::VIDEO;
 
-void Motion::setTest() {
+//debug overlays are rendered on a background thread into a side by side " debug" movie (or image sequence)
+//they go to 7_debug, as the merging and clean up in 3_process would take them for output chunks
+void Motion::setTest(bool imageSequence) {
     test = true;
+    debugOutputType = imageSequence ? DebugSink::OutputType::IMAGES : DebugSink::OutputType::VIDEO;
+}
+
+void Motion::setRoiTracking(bool on) {
+    roiTracking = on;
+}
+
+void Motion::setSweepMode(SweepMode mode) {
+    sweepMode = mode;
 }
 
 //replace part in string
@@ -97,235 +105,57 @@ std::string ReplaceString(std::string subject, const std::string& search,
     return subject;
 }
 
-//calculate zoom window from bounding rectangle
-void calcZoom(Rect boundingRectangle, double &zoomXPosition, double &zoomFactor) {
-    
-    static Filter leftBorderFilter(0, Filter::BorderType::LEFT);
-    static Filter rightBorderFilter(IN_VIDEO_SIZE.width * reduceFactor, Filter::BorderType::RIGHT);
-    static Filter bottomBorderFilter(IN_VIDEO_SIZE.height * reduceFactor, Filter::BorderType::BOTTOM);
-    static Filter zoomXPositionFilter(IN_VIDEO_SIZE.width * reduceFactor, Filter::BorderType::NONE);
-    static Filter zoomFactorFilter(0, Filter::BorderType::NONE);
-    
-    //add bezel to bounding rectangle borders
-    double leftBorderTarget = boundingRectangle.x - BEZEL;
-    double rightBorderTarget = boundingRectangle.x + boundingRectangle.width + BEZEL;
-    
-    //limit lower target size to MAX_ZOOMED_WINDOW
-    const static double max_zoomed_window_width = MAX_ZOOMED_WINDOW.width * reduceFactor;
-    if (rightBorderTarget - leftBorderTarget < max_zoomed_window_width ) {
-        
-        //calculate the borders for a max zoom to the actual camera center
-        double actualCenter = zoomXPositionFilter.getValue();
-        double leftBorderLimit = actualCenter - max_zoomed_window_width / 2;
-        double rightBorderLimit = actualCenter + max_zoomed_window_width / 2;
-        
-        //block 'intruding' borders into above borders - we can't zoom more anyway, so let the target move in the max zoom window
-        if (leftBorderTarget > leftBorderLimit) {
-            leftBorderTarget = leftBorderLimit;
-        }
-        if (rightBorderTarget < rightBorderLimit) {
-            rightBorderTarget = rightBorderLimit;
-        }
-        //if zoom window is still too narrow, correct evenly on both sides
-        if (rightBorderTarget - leftBorderTarget < max_zoomed_window_width) {
-            double correction = (max_zoomed_window_width - rightBorderTarget + leftBorderTarget) / 2;
-            leftBorderTarget = leftBorderTarget - correction;
-            rightBorderTarget = rightBorderTarget + correction;
-        }
-    }
-    
-    //filter borders
-    int leftBorder = leftBorderFilter.update(leftBorderTarget);
-    int rightBorder = rightBorderFilter.update(rightBorderTarget);
-    int bottomBorder = bottomBorderFilter.update(boundingRectangle.y + boundingRectangle.height + BEZEL / 2);
-    
-    //calculate zoom factor, only from width yet
-    double tempWidth = (rightBorder - leftBorder) / reduceFactor;
-    zoomFactor =  (IN_VIDEO_SIZE.width - tempWidth) / (IN_VIDEO_SIZE.width - MAX_ZOOMED_WINDOW.width) * 100;
-    
-    //check bottom border, if it results in smaller zoomFactor, take that one
-    double tempHeight = (bottomBorder - IN_VIDEO_SIZE.height * reduceFactor / 2) / reduceFactor * 2; //vertical zoom center is always height/2
-    double vertZoomFactor = (IN_VIDEO_SIZE.height - tempHeight) / (IN_VIDEO_SIZE.height - MAX_ZOOMED_WINDOW.height) * 100;
-    
-    if (vertZoomFactor < zoomFactor) {
-        zoomFactor = vertZoomFactor;
-    }
-    
-    zoomFactor = zoomFactorFilter.update(zoomFactor);
-    
-    if (zoomFactor > 100.0) {
-        zoomFactor = 100.0;
-    } else if (zoomFactor < 0.0) {
-        zoomFactor = 0.0;
-    }
-    
-    zoomXPosition = (leftBorder + rightBorder) / 2;
-    zoomXPosition = zoomXPositionFilter.update(zoomXPosition);
-
-}
-
-void reduce(Mat in, Mat &out) {
-    resize(in, out, Size(), reduceFactor, reduceFactor, INTER_CUBIC);
+//output chunk of one area, e.g. "2016-01-05 10-11-12 CAM0 area 2 003 processing.mov"
+//the area label is left out, if the camera covers a single area
+static string chunkFileName(const string &path, const string &inFileName, const string &areaLabel, int fileCount) {
+    //add leading 0 to fileCount so later the snippets get sorted correctly (001, 002, 003, ...)
+    std::string fileCountString = std::to_string(fileCount);
+    fileCountString = std::string(3 - fileCountString.length(), '0') + fileCountString;
+    return path + inFileName + areaLabel + " " + fileCountString + " processing.mov";
 }
 
-//tries to put max 4 clusters
-void cluster(vector<Point> nonZeroPoints, Mat &redFrame, Mat &thresholdImage) {
-    
-    //cast points into 2D floating point array
-    int sampleCount = (int) nonZeroPoints.size();
-    Mat points(sampleCount, 1, CV_32FC2);
-    for (int i = 0; i < sampleCount; i++) {
-        points.at<Point2f>(i) = nonZeroPoints.at(i);
-    }
-    
-    int clusterCount = MIN(4, sampleCount);
-    Mat centers, labels;
-    static ObjectHandler objHandler = ObjectHandler(redFrame.cols, redFrame.rows);
-    vector<Point2f> objects = objHandler.getObjects();
-
-    if (test) {
-        //draw circles around objects
-        for (auto obj = objects.begin(); obj != objects.end(); ++obj) {
-            circle(redFrame, *obj, 30, Scalar(0, 0, 255), FILLED, LINE_AA);
-        }
-    }
-    
-    if (clusterCount > 0) {
-        TermCriteria crit = TermCriteria( TermCriteria::EPS+TermCriteria::COUNT, 5, 1.0);
-        
-        kmeans(points, clusterCount, labels, crit, 3, KMEANS_PP_CENTERS, centers);
-        
-        objects = objHandler.update(centers);
-        
-        if (test) {
-            //draw circles around the centers for debugging
-            for (int i = 0; i < centers.rows; ++i)
-            {
-                Point2f c = centers.at<Point2f>(i);
-                circle( redFrame, c, 60, Scalar(255, 0, 255), 1, LINE_AA );
-            }
-            
-            //draw sample points (non zero points)
-            for (int i = 0; i < sampleCount; i++) {
-                Point ipt = points.at<Point2f>(i);
-                circle(redFrame, ipt, 1, Scalar(255, 255, 0), FILLED, LINE_AA);
-            }
-        }
-    }
-    
-    //draw circles around objects to thresholdImage, so later zoom frame detection will take them into account
-    //TODO: this is probably not the best way to interface the objects...
-    for (auto obj = objects.begin(); obj != objects.end(); ++obj) {
-        circle(thresholdImage, *obj, 30, Scalar(255), FILLED, LINE_AA);
+//file size in bytes, 0 if there is no such file
+static double fileSize(const string &fileName) {
+    struct stat fileStat;
+    if (stat(fileName.c_str(), &fileStat) != 0) {
+        return 0;
     }
-
+    return (double) fileStat.st_size;
 }
 
-void trackObjects(Mat thresholdImage, Mat &cameraFeed, Mat &zoomedImage, Mat redFrame) {
-    
-    //find non zero points
-    vector<Point> points;
-    findNonZero(thresholdImage, points);
-
-    //try clustering
-    cluster(points, redFrame, thresholdImage);
-    
-    //calculate the bounding rectangle for all non zero points
-    //TODO: clumsy!
-    findNonZero(thresholdImage, points); //find non zero points again, as thresholdImage has been altered by cluster
-    
-    //bounding rectangle. If computed image is empty, take whole picture
-    if (points.size() > 0) {
-        objectBoundingRectangle = boundingRect(points);
-    } else {
-        objectBoundingRectangle.x = 0;
-        objectBoundingRectangle.y = 0;
-        objectBoundingRectangle.width = redFrame.cols;
-        objectBoundingRectangle.height = redFrame.rows;
-    }
-    
-
-    //calculate zoom factor
-    int cameraVerticalPosition = (int) IN_VIDEO_SIZE.height / 2;
-    Size zoomedWindow = MAX_ZOOMED_WINDOW;
-    
-    double zoomCenter = 0; //calculate only x position, as y position of camera is fixed
-    double zoomFactor = 0.0;  // zoomFaktor will be between 0 (no zoom) and 100 (max zoom)
-        
-    calcZoom(objectBoundingRectangle, zoomCenter, zoomFactor);
-
-    //make zoomed Image
-    zoomedWindow.width = (int)(IN_VIDEO_SIZE.width - zoomFactor * (IN_VIDEO_SIZE.width - MAX_ZOOMED_WINDOW.width) / 100);
-    zoomedWindow.height = (int)(IN_VIDEO_SIZE.height - zoomFactor * (IN_VIDEO_SIZE.height - MAX_ZOOMED_WINDOW.height) / 100);
-
-    if (zoomedWindow.width > IN_VIDEO_SIZE.width) {
-        zoomedWindow.width = IN_VIDEO_SIZE.width;
-    }
-    if (zoomedWindow.height > IN_VIDEO_SIZE.height) {
-        zoomedWindow.height = IN_VIDEO_SIZE.height;
-    }
-    
-    Mat cutImage;
-    int xx, yy; //top left corner of zoomed window
-    xx = (int)( zoomCenter / reduceFactor - zoomedWindow.width / 2 );
-    yy = cameraVerticalPosition - ( (int) zoomedWindow.height / 2 ); // fix vertical camera swing
-    
-    //limit against border of image
-    if (xx < 0) xx = 0;
-    if (yy < 0) yy = 0;
-    
-    int maxX = IN_VIDEO_SIZE.width - zoomedWindow.width;
-    int maxY = IN_VIDEO_SIZE.height - zoomedWindow.height;
-    
-    if (xx > maxX) xx = maxX;
-    if (yy > maxY) yy = maxY;
-    
-    //cout << "cutImage " << xx << " " << yy << " " << zoomedWindow.width << " " << zoomedWindow.height << "\n";
-    
-    cutImage = cameraFeed(Rect(xx, yy, zoomedWindow.width, zoomedWindow.height));
-    resize(cutImage, zoomedImage, OUT_VIDEO_SIZE, 0, 0, INTER_CUBIC);
-    
-    //draw debug information
-    if (test) {
-        
-        int camY = (int) cameraVerticalPosition / 2;
-
-        //draw center of camera (after inertia filtering)
-        line(redFrame, Point(zoomCenter, camY + 25), Point(zoomCenter, camY - 25), Scalar(255, 255, 0), 3);
-        line(redFrame, Point(zoomCenter + 25, camY), Point(zoomCenter - 25, camY), Scalar(255, 255, 0), 3);
-        
-        //draw bounding rectangle
-        rectangle(redFrame, objectBoundingRectangle.tl(), objectBoundingRectangle.br(), Scalar(0, 255, 255), 3);
-        
-        //draw zoom rectangle
-        Point tl(xx, yy);
-        Point br(xx + zoomedWindow.width, yy + zoomedWindow.height);
-        tl = tl * reduceFactor;
-        br = br * reduceFactor;
-        rectangle(redFrame, tl, br, Scalar(255, 200, 0), 3);
-        
-        imshow("Movement", redFrame);
-    }
-    
+//zooming and writing of one area
+struct AreaOutput {
+    string label;
+    string fileName;
+    VideoWriter video;
+    Mat zoomedImage;
+    MotionEngine::Result result;
+};
+
+struct AreaOutputJob {
+    const Mat *origFrame;
+    AreaOutput *outputs;
+};
+
+//runs on a worker thread of the ResourceGovernor, each area has its own writer
+static void writeArea(void *context, size_t index) {
+    AreaOutputJob *job = (AreaOutputJob *) context;
+    AreaOutput &output = job->outputs[index];
+    
+    //make zoomed image
+    resize((*job->origFrame)(output.result.crop), output.zoomedImage, OUT_VIDEO_SIZE, 0, 0, INTER_CUBIC);
+    output.video.write(output.zoomedImage);
 }
 
-void Motion::processVideo(const char * pathName) {
+//returns the number of areas, each one has its own series of " processing" movies, 0 on error
+int Motion::processVideo(const char * pathName) {
     cout << "Motion.processVideo started with " << pathName << "\n";
     
-    //some boolean variables for testing
-    bool showDifference = false;
+    //some boolean variables for interactive testing, needs a display
     bool showActualFrame = false;
     bool showOutput = false;
     bool showMask = false;
-    
-    if (test) {
-        showDifference = false;
-        showActualFrame = false;
-        showOutput = true;
-        showMask = false;
-    }
-    
-    //TODO: calculate age of objects, if very young, do not take into account
+    bool showAny = showActualFrame or showOutput or showMask;
     
     //strip input file name of ´new´
     string sPathName = (string) pathName;
@@ -340,158 +170,202 @@ void Motion::processVideo(const char * pathName) {
     //set up the matrices that we we'll need
     //the input frame
     Mat origFrame;
-    //the reduced input frame$
-    Mat frame;
-    //their grayscale images (needed for comparing)
-    Mat grayImage1, grayImage2;
-    //resulting difference (and masked) image
-    Mat differenceImage;
-    //thresholded difference image (for use in findContours() function)
-    Mat thresholdImage;
-    //zoomed image
-    Mat zoomedImage;
     
-    //mask
-    Mat mask = imread(path + "../0_mask/horseSampleShotMask.png", IMREAD_GRAYSCALE);
+    //masks, one per area
+    vector<Mat> masks;
+    masks.push_back(imread(path + "../0_mask/horseSampleShotMask.png", IMREAD_GRAYSCALE));
     
-    if (!mask.data)                              // Check for invalid input
+    if (!masks.front().data)                     // Check for invalid input
     {
         cout << "NO MASK IMAGE FOUND" << std::endl;
-    } else {
-        reduce(mask, mask);
-        threshold(mask, mask, SENSITIVITY_VALUE, 255, THRESH_BINARY);
     }
+    for (int i = 2; i <= MAX_AREAS; i++) {
+        Mat mask = imread(path + "../0_mask/horseSampleShotMask " + to_string(i) + ".png", IMREAD_GRAYSCALE);
+        if (!mask.data) {
+            break;
+        }
+        masks.push_back(mask);
+    }
+    int areaCount = (int) masks.size();
     
     //video capture object.
     VideoCapture capture;
     
-    //video output
-    VideoWriter outVideo;
+    //replaces the capture object, if the motion vectors of the codec are used
+    unique_ptr<MotionVectorReader> mvReader;
+    //coarse motion map of the actual frame, from the motion vectors
+    Mat motionMap;
     
-    //we can loop the video by re-opening the capture every time the video reaches its last frame
-    capture.open(pathName);
+    //video output, one per area
+    vector<AreaOutput> outputs(areaCount);
+    for (int i = 0; i < areaCount; i++) {
+        outputs[i].label = areaCount > 1 ? " area " + to_string(i + 1) : "";
+    }
     
-    if (!capture.isOpened()) {
-        cout << "ERROR ACQUIRING VIDEO FEED\n";
-        return;
+    //we can loop the video by re-opening the capture every time the video reaches its last frame
+    double fps = 0;
+    if (sweepMode == SweepMode::MOTION_VECTORS) {
+        mvReader.reset(new MotionVectorReader());
+        if (!mvReader->open(pathName)) {
+            cout << "ERROR ACQUIRING VIDEO FEED\n";
+            return 0;
+        }
+        fps = mvReader->getFps();
+    } else {
+        //the decoder threads of VideoCapture are not under the worker cap of the ResourceGovernor
+        capture.open(pathName);
+        
+        if (!capture.isOpened()) {
+            cout << "ERROR ACQUIRING VIDEO FEED\n";
+            return 0;
+        }
+        fps = capture.get(CAP_PROP_FPS);
     }
     
+    auto readFrame = [&]() {
+        return mvReader ? mvReader->read(origFrame, motionMap) : capture.read(origFrame);
+    };
+    
     //open output stream
     //working codes:
     //CV_FOURCC('j', 'p', 'e', 'g');
     //CV_FOURCC('m', 'p', '4', 'v');
     //int videoCodec = CV_FOURCC('m', 'p', '4', 'v');
-    int videoCodec = outVideo.fourcc('m', 'p', '4', 'v');
+    int videoCodec = VideoWriter::fourcc('m', 'p', '4', 'v');
     
     int frameCount = 0; //we track the file size to limit max file size
     int fileCount = 1; //files are numbered,
     
-    string fileName = path + inFileName + " 00" + std::to_string(fileCount) + " processing.mov";
-    
-    outVideo.open(fileName, videoCodec, capture.get(CAP_PROP_FPS), OUT_VIDEO_SIZE, true);
-    if (!outVideo.isOpened()) {
-        cout << "ERROR OPENING OUTPUT STREAM\n";
-        return;
+    for (auto output = outputs.begin(); output != outputs.end(); ++output) {
+        output->fileName = chunkFileName(path, inFileName, output->label, fileCount);
+        output->video.open(output->fileName, videoCodec, fps, OUT_VIDEO_SIZE, true);
+        if (!output->video.isOpened()) {
+            cout << "ERROR OPENING OUTPUT STREAM\n";
+            return 0;
+        }
     }
     
-    //read frame
-    bool success = capture.read(origFrame);
-    
-    //reduce frame to gain speed
-    reduce(origFrame, frame);
+    //read frame, it only primes the frame differencing
+    if (!readFrame()) {
+        cout << "ERROR READING FIRST FRAME\n";
+        return 0;
+    }
+    if (origFrame.size() != IN_VIDEO_SIZE) {
+        cout << "unexpected input video size " << origFrame.cols << "x" << origFrame.rows << "\n";
+    }
     
-    //convert frame to gray scale for frame differencing
-    if (success) {
-        cvtColor(frame, grayImage2, COLOR_BGR2GRAY);
+    //the motion tracking, file handling stays here
+    MotionEngine engine(origFrame.cols, origFrame.rows, areaCount);
+    for (int i = 0; i < areaCount; i++) {
+        engine.setMask(masks[i], i);
     }
+    engine.setRoiTracking(roiTracking);
+    switch (sweepMode) {
+        case SweepMode::FULL:
+            engine.setSweepMode(MotionEngine::SweepMode::FULL);
+            break;
+        case SweepMode::PYRAMID:
+            engine.setSweepMode(MotionEngine::SweepMode::PYRAMID);
+            break;
+        case SweepMode::MOTION_VECTORS:
+            engine.setSweepMode(MotionEngine::SweepMode::MOTION_VECTORS);
+            break;
+    }
+    engine.process(origFrame, motionMap);
     
     if (showMask) {
-        imshow("Mask", mask);
+        imshow("Mask", masks.front());
     }
     
+    //debug overlays, rendered in the background
+    unique_ptr<DebugSink> debugSink;
+    if (test) {
+        string debugPath = path + "../7_debug/";
+        mkdir(debugPath.c_str(), 0755);
+        debugSink.reset(new DebugSink(debugPath + inFileName + " debug", debugOutputType, fps));
+    }
+    DebugSink::Overlay overlay;
+    
+    //backs off while recording or under load, the input is accounted evenly over its frames
+    ResourceGovernor &governor = ResourceGovernor::shared();
+    double inputFrames = mvReader ? mvReader->getFrameCount() : capture.get(CAP_PROP_FRAME_COUNT);
+    double inputBytesPerFrame = inputFrames > 0 ? fileSize(pathName) / inputFrames : 0;
+    governor.beginJob();
     
-    while (capture.read(origFrame)) {
+    while (readFrame()) {
+        
+        governor.ioDone(inputBytesPerFrame);
         
         //check for max file size, if MAX_FRAMES is exceeded, open a new file.
         if (frameCount > MAX_FRAMES) {
             frameCount = 0;
-            outVideo.release();
             fileCount++;
-            //add leading 0 to fileCount so later the snippets get sorted correctly (001, 002, 003, ...)
-            std::string fileCountString = std::to_string(fileCount);
-            fileCountString = std::string(3 - fileCountString.length(), '0') + fileCountString;
-            fileName = path + inFileName + " " + fileCountString + " processing.mov";
-            outVideo.open(fileName, videoCodec, capture.get(CAP_PROP_FPS), OUT_VIDEO_SIZE, true);
-            if (!outVideo.isOpened()) {
-                cout << "ERROR OPENING OUTPUT STREAM\n";
-                return;
+            for (auto output = outputs.begin(); output != outputs.end(); ++output) {
+                output->video.release();
+                governor.ioDone(fileSize(output->fileName));
+                output->fileName = chunkFileName(path, inFileName, output->label, fileCount);
+                output->video.open(output->fileName, videoCodec, fps, OUT_VIDEO_SIZE, true);
+                if (!output->video.isOpened()) {
+                    cout << "ERROR OPENING OUTPUT STREAM\n";
+                    governor.endJob();
+                    return 0;
+                }
             }
         }
-
-        //set first grayImage to the last one read from camera
-        swap(grayImage1, grayImage2);
-        
-        reduce(origFrame, frame);
         
         if (showActualFrame) {
-            imshow("actualFrame", frame);
+            imshow("actualFrame", origFrame);
         }
         
-        //convert frame to gray scale for frame differencing
-        cvtColor(frame, grayImage2, COLOR_BGR2GRAY);
-        
-        //perform frame differencing with the sequential images. This will output an "intensity image"
-        //do not confuse this with a threshold image, we will need to perform thresholding afterwards.
-        absdiff(grayImage1, grayImage2, differenceImage);
-        
-        //now mask the result to filter only the relevant regions of the picture
-        Mat temp;
-        differenceImage.copyTo(temp, mask);
-        temp.copyTo(differenceImage);
-        
-        //threshold intensity image at a given sensitivity value
-        threshold(differenceImage, thresholdImage, SENSITIVITY_VALUE, 255, THRESH_BINARY);
-        
-        //blur the image to get rid of the noise. This will output an intensity image
-        blur(thresholdImage, thresholdImage, Size(BLUR_SIZE, BLUR_SIZE));
-        
-        //threshold again to obtain binary image from blur output
-        threshold(thresholdImage, thresholdImage, SENSITIVITY_VALUE, 255, THRESH_BINARY);
-        
-        if (showDifference) {
-            //show the difference image and the threshold image
-            imshow("Difference Image", differenceImage);
-            imshow("Threshold Image", thresholdImage);
+        //search for movement, the areas share the decoded frame and the frame differencing
+        vector<MotionEngine::Result> results = engine.processAreas(origFrame, motionMap, debugSink ? &overlay : nullptr);
+        for (int i = 0; i < areaCount; i++) {
+            outputs[i].result = results[i];
         }
         
-        //search for movement in our thresholded image
-        trackObjects(thresholdImage, origFrame, zoomedImage, frame);
+        //make and write the zoomed images of all areas in parallel, as far as the recording allows
+        AreaOutputJob job = { &origFrame, outputs.data() };
+        governor.apply(areaCount, &job, writeArea);
         
         if (showOutput) {
-            imshow("Zoomed Image", zoomedImage);
+            imshow("Zoomed Image", outputs.front().zoomedImage);
         }
         
-        outVideo.write(zoomedImage);
-        
         //update file size / frame count
         frameCount++;
         
-        if (showDifference) {
-            //show the threshold image after it's been "blurred"
-            imshow("Final Threshold Image", thresholdImage);
+        if (debugSink) {
+            //hand over copies, as the analysis frame and zoomedImage are reused for the next frame
+            overlay.frame = engine.getAnalysisFrame().clone();
+            overlay.zoomedImage = outputs.front().zoomedImage.clone();
+            debugSink->push(std::move(overlay));
+            overlay = DebugSink::Overlay();
         }
         
-        if (test) {
+        if (showAny) {
             //this 1ms delay is necessary for proper operation of this program
             //if removed, frames will not have enough time to refresh and a blank
             //image will appear.
             waitKey(1);
         }
+        
+        governor.frameDone();
     }
     
     capture.release();
-    outVideo.release();
-    return;
+    mvReader.reset();
+    for (auto output = outputs.begin(); output != outputs.end(); ++output) {
+        output->video.release();
+        governor.ioDone(fileSize(output->fileName));
+    }
+    
+    ResourceGovernor::Report report = governor.endJob();
+    cout << "Motion.processVideo throttled " << report.throttleCount << " times in " << report.frames << " frames ("
+         << report.busyFrames << " while recording or under load), slept " << fixed << setprecision(1)
+         << report.frameRateSleep << " s for the frame rate and " << report.ioSleep << " s for "
+         << report.ioBytes / 1e6 << " MB of I/O, " << report.minWorkers << " to " << report.maxWorkers << " worker threads\n" << defaultfloat;
+    
+    //waits until all debug frames are rendered
+    debugSink.reset();
+    return areaCount;
 }
-
-
@@ -13,8 +13,19 @@
 #include <stdio.h>
 class Motion {
 public:
-    void processVideo(const char * videoFileName);
-    void setTest();
+    //how a full sweep looks for motion, see MotionEngine::SweepMode
+    //this header stays free of OpenCV, as it is included by the Objective-C++ wrapper
+    enum class SweepMode {
+        FULL, // difference the whole reduced frame
+        PYRAMID, // difference a coarse level first, then only the active tiles of the reduced frame, misses motion that keeps the coarse averages
+        MOTION_VECTORS // decode with FFmpeg and take the active tiles from the codec's motion vectors
+    };
+    
+    //returns the number of areas, 0 on error
+    int processVideo(const char * videoFileName);
+    void setTest(bool imageSequence = false);
+    void setRoiTracking(bool on);
+    void setSweepMode(SweepMode mode);
 };
 
 #endif /* Motion_hpp */
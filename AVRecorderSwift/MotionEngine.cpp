@@ -0,0 +1,593 @@
+//
+//  MotionEngine.cpp
+//  AVRecorderSwift
+//
+//  Created by Andreas Pohl on 19.10.26.
+//  Copyright © 2026 Andreas Pohl. All rights reserved.
+//
+//  Motion tracking moved here from Motion.cpp, originally written by Kyle Hounslow, December 2013
+//  and modified by Andreas Pohl, November 2014 to December 2015, see Motion.cpp for the license.
+//
+
+#include "MotionEngine.hpp"
+#include "ResourceGovernor.hpp"
+
+#include <iostream>
+
+//our sensitivity value to be used in the threshold() function
+const static int SENSITIVITY_VALUE = 30; //was 20 initially
+//size of blur used to smooth the intensity image output from absdiff() function
+const static int BLUR_SIZE = 10;
+
+//factor for reducing the frames for speed
+const static double reduceFactor = 0.5;
+
+//bezel, free room between object and zoomed window
+const int BEZEL = 100 * reduceFactor;
+
+//max zoom window, relative to the input frame (1920 x 1080 --> 640 x 360)
+const static int MAX_ZOOM = 3;
+
+//a full frame sweep is done at least every FULL_SWEEP_INTERVAL frames to catch objects entering the scene
+const static int FULL_SWEEP_INTERVAL = 12;
+
+//half size of the analysed region around a predicted object position
+const int ROI_RADIUS = 240 * reduceFactor;
+
+//coarse pyramid level, relative to the reduced frame (0.25 * 0.5 --> 1/8 of the input video)
+const static double COARSE_FACTOR = 0.25;
+
+//averaging in the coarse level weakens the differences, so it is thresholded lower
+const static int COARSE_SENSITIVITY_VALUE = SENSITIVITY_VALUE / 2;
+
+//tile size in coarse pixels (8 --> 32 pixels in the reduced frame)
+const static int TILE_SIZE = 8;
+
+struct MotionEngine::AreaJob {
+    MotionEngine *engine;
+    Result *results;
+    DebugSink::Overlay *overlay;
+};
+
+MotionEngine::Area::Area(Size analysisSize) :
+    maskRectangle(0, 0, analysisSize.width, analysisSize.height),
+    objHandler(analysisSize.width, analysisSize.height),
+    leftBorderFilter(0, Filter::BorderType::LEFT),
+    rightBorderFilter(analysisSize.width, Filter::BorderType::RIGHT),
+    bottomBorderFilter(analysisSize.height, Filter::BorderType::BOTTOM),
+    zoomXPositionFilter(analysisSize.width, Filter::BorderType::NONE),
+    zoomFactorFilter(0, Filter::BorderType::NONE) {
+}
+
+MotionEngine::MotionEngine(int width, int height, int areaCount) :
+    inputSize(width, height),
+    analysisSize((int) (width * reduceFactor), (int) (height * reduceFactor)),
+    maxZoomedWindow(width / MAX_ZOOM, height / MAX_ZOOM) {
+    
+    for (int i = 0; i < MAX(1, areaCount); i++) {
+        areas.push_back(unique_ptr<Area>(new Area(analysisSize)));
+    }
+}
+
+//mask in any resolution, non zero where motion is of interest
+void MotionEngine::setMask(const Mat &inMask, int area) {
+    if (area < 0 or area >= (int) areas.size()) {
+        cout << "MotionEngine: there is no area " << area << "\n";
+        return;
+    }
+    //may run on any thread, e.g. the capture queue, like processAreas
+    ResourceGovernor::OpenCvScope openCvScope;
+    Mat &mask = areas[area]->mask;
+    Mat &coarseMask = areas[area]->coarseMask;
+    Rect &maskRectangle = areas[area]->maskRectangle;
+    areas[area]->mapMask.release();
+    maskRectangle = Rect(0, 0, analysisSize.width, analysisSize.height);
+    if (!inMask.data) {
+        mask.release();
+        coarseMask.release();
+        return;
+    }
+    resize(inMask, mask, analysisSize, 0, 0, INTER_CUBIC);
+    threshold(mask, mask, SENSITIVITY_VALUE, 255, THRESH_BINARY);
+    
+    //an empty mask keeps the whole frame
+    Rect unmasked = boundingRect(mask);
+    if (unmasked.area() > 0) {
+        maskRectangle = unmasked;
+    }
+    
+    //a coarse pixel counts if any of its pixels is unmasked
+    resize(mask, coarseMask, Size(), COARSE_FACTOR, COARSE_FACTOR, INTER_AREA);
+    threshold(coarseMask, coarseMask, 0, 255, THRESH_BINARY);
+}
+
+int MotionEngine::getAreaCount() {
+    return (int) areas.size();
+}
+
+Size MotionEngine::getInputSize() {
+    return inputSize;
+}
+
+//between full frame sweeps, only the regions around the predicted positions of the tracked objects are analysed
+void MotionEngine::setRoiTracking(bool on) {
+    roiTracking = on;
+}
+
+void MotionEngine::setSweepMode(SweepMode mode) {
+    sweepMode = mode;
+}
+
+//the reduced frame of the last processed frame, color or gray depending on the input
+//on frames without any motion in the codec's motion map, it is the one of the last frame with motion
+const Mat &MotionEngine::getAnalysisFrame() {
+    return frame;
+}
+
+//reduce the frame to gain speed and convert it to gray scale for frame differencing
+void MotionEngine::reduce(const Mat &in) {
+    swap(grayImage1, grayImage2);
+    //the coarse level of the last frame is kept along with it, so it is not reduced again
+    swap(coarse1, coarse2);
+    coarse1Valid = coarse2Valid;
+    coarse2Valid = false;
+    if (in.channels() == 1) {
+        //luma only, the gray image is the analysis frame
+        resize(in, grayImage2, analysisSize, 0, 0, INTER_CUBIC);
+        frame = grayImage2;
+        return;
+    }
+    resize(in, frame, analysisSize, 0, 0, INTER_CUBIC);
+    cvtColor(frame, grayImage2, frame.channels() == 4 ? COLOR_BGRA2GRAY : COLOR_BGR2GRAY);
+}
+
+//frame differencing for the regions of all areas in one pass, the areas only read the result
+void MotionEngine::differentiate() {
+    
+    differenceImage.create(grayImage2.size(), CV_8UC1);
+    
+    for (auto area = areas.begin(); area != areas.end(); ++area) {
+        for (auto region = (*area)->regions.begin(); region != (*area)->regions.end(); ++region) {
+            
+            //perform frame differencing with the sequential images. This will output an "intensity image"
+            //do not confuse this with a threshold image, we will need to perform thresholding afterwards.
+            Mat target = differenceImage(*region);
+            absdiff(grayImage1(*region), grayImage2(*region), target);
+        }
+    }
+}
+
+//masking, thresholding and blurring of the difference image, only within the actual regions of the area
+//returns false, if the region of a moving object does not contain motion
+//objects standing still may stay without motion for a long time, they are not lost
+bool MotionEngine::detectMotion(Area &area) {
+    
+    Mat &thresholdImage = area.thresholdImage;
+    thresholdImage.create(grayImage2.size(), CV_8UC1);
+    thresholdImage.setTo(Scalar(0));
+    
+    bool movingRegionsActive = true;
+    Mat maskedDifference, regionThreshold;
+    
+    for (size_t i = 0; i < area.regions.size(); i++) {
+        const Rect &region = area.regions[i];
+        
+        //now mask the result to filter only the relevant regions of the picture
+        //the difference image is shared with the other areas, so it is never written here
+        if (area.mask.data) {
+            bitwise_and(differenceImage(region), area.mask(region), maskedDifference);
+        } else {
+            maskedDifference = differenceImage(region);
+        }
+        
+        //threshold intensity image at a given sensitivity value
+        threshold(maskedDifference, regionThreshold, SENSITIVITY_VALUE, 255, THRESH_BINARY);
+        
+        //blur the image to get rid of the noise. This will output an intensity image
+        blur(regionThreshold, regionThreshold, Size(BLUR_SIZE, BLUR_SIZE));
+        
+        //threshold again to obtain binary image from blur output
+        threshold(regionThreshold, regionThreshold, SENSITIVITY_VALUE, 255, THRESH_BINARY);
+        
+        if (i < area.regionMoving.size() and area.regionMoving[i] and countNonZero(regionThreshold) == 0) {
+            movingRegionsActive = false;
+        }
+        
+        //regions may overlap, so combine them
+        Mat target = thresholdImage(region);
+        bitwise_or(target, regionThreshold, target);
+    }
+    
+    return movingRegionsActive;
+}
+
+//coarse to fine: find the active tiles on a coarse pyramid level, only they get analysed in the reduced frame
+//the coarse level is computed once per frame and then masked for each area
+void MotionEngine::findActiveRegions(Area &area) {
+    
+    if (!coarse2Valid) {
+        //the previous frame only lacks its coarse level, if it was not swept on it (e.g. ROI tracking)
+        if (!coarse1Valid) {
+            resize(grayImage1, coarse1, Size(), COARSE_FACTOR, COARSE_FACTOR, INTER_AREA);
+            coarse1Valid = true;
+        }
+        resize(grayImage2, coarse2, Size(), COARSE_FACTOR, COARSE_FACTOR, INTER_AREA);
+        coarse2Valid = true;
+        
+        absdiff(coarse1, coarse2, coarseDifference);
+        threshold(coarseDifference, coarseDifference, COARSE_SENSITIVITY_VALUE, 255, THRESH_BINARY);
+    }
+    
+    Mat activeCoarse = coarseDifference;
+    if (area.coarseMask.data) {
+        bitwise_and(coarseDifference, area.coarseMask, activeCoarse);
+    }
+    
+    //one pixel per tile, non zero if any coarse pixel of the tile moved
+    int tilesX = (activeCoarse.cols + TILE_SIZE - 1) / TILE_SIZE;
+    int tilesY = (activeCoarse.rows + TILE_SIZE - 1) / TILE_SIZE;
+    resize(activeCoarse, area.tiles, Size(tilesX, tilesY), 0, 0, INTER_AREA);
+    
+    //take the neighbours as well, the object might be only partly above the coarse threshold
+    dilate(area.tiles, area.tiles, Mat());
+    
+    regionsFromTiles(area);
+}
+
+//active tiles are merged to horizontal runs and enlarged by the blur size, so blurring does not cut them
+//the tile grid covers the whole frame, in any resolution
+void MotionEngine::regionsFromTiles(Area &area) {
+    
+    Mat &tiles = area.tiles;
+    int tilesX = tiles.cols;
+    int tilesY = tiles.rows;
+    double tileWidth = (double) grayImage2.cols / tilesX;
+    double tileHeight = (double) grayImage2.rows / tilesY;
+    Rect fullFrame = Rect(0, 0, grayImage2.cols, grayImage2.rows);
+    
+    for (int y = 0; y < tilesY; y++) {
+        int x = 0;
+        while (x < tilesX) {
+            if (tiles.at<uchar>(y, x) == 0) {
+                x++;
+                continue;
+            }
+            int start = x;
+            while (x < tilesX and tiles.at<uchar>(y, x) > 0) {
+                x++;
+            }
+            Rect region = Rect((int) (start * tileWidth) - BLUR_SIZE, (int) (y * tileHeight) - BLUR_SIZE,
+                               (int) ((x - start) * tileWidth) + 2 * BLUR_SIZE, (int) tileHeight + 2 * BLUR_SIZE) & fullFrame;
+            area.regions.push_back(region);
+        }
+    }
+}
+
+//calculate zoom window from bounding rectangle
+void MotionEngine::calcZoom(Area &area, Rect boundingRectangle, double &zoomXPosition, double &zoomFactor) {
+    
+    //add bezel to bounding rectangle borders
+    double leftBorderTarget = boundingRectangle.x - BEZEL;
+    double rightBorderTarget = boundingRectangle.x + boundingRectangle.width + BEZEL;
+    
+    //limit lower target size to maxZoomedWindow
+    const double max_zoomed_window_width = maxZoomedWindow.width * reduceFactor;
+    if (rightBorderTarget - leftBorderTarget < max_zoomed_window_width ) {
+        
+        //calculate the borders for a max zoom to the actual camera center
+        double actualCenter = area.zoomXPositionFilter.getValue();
+        double leftBorderLimit = actualCenter - max_zoomed_window_width / 2;
+        double rightBorderLimit = actualCenter + max_zoomed_window_width / 2;
+        
+        //block 'intruding' borders into above borders - we can't zoom more anyway, so let the target move in the max zoom window
+        if (leftBorderTarget > leftBorderLimit) {
+            leftBorderTarget = leftBorderLimit;
+        }
+        if (rightBorderTarget < rightBorderLimit) {
+            rightBorderTarget = rightBorderLimit;
+        }
+        //if zoom window is still too narrow, correct evenly on both sides
+        if (rightBorderTarget - leftBorderTarget < max_zoomed_window_width) {
+            double correction = (max_zoomed_window_width - rightBorderTarget + leftBorderTarget) / 2;
+            leftBorderTarget = leftBorderTarget - correction;
+            rightBorderTarget = rightBorderTarget + correction;
+        }
+    }
+    
+    //filter borders
+    int leftBorder = area.leftBorderFilter.update(leftBorderTarget);
+    int rightBorder = area.rightBorderFilter.update(rightBorderTarget);
+    int bottomBorder = area.bottomBorderFilter.update(boundingRectangle.y + boundingRectangle.height + BEZEL / 2);
+    
+    //calculate zoom factor, only from width yet
+    double tempWidth = (rightBorder - leftBorder) / reduceFactor;
+    zoomFactor =  (double) (inputSize.width - tempWidth) / (inputSize.width - maxZoomedWindow.width) * 100;
+    
+    //check bottom border, if it results in smaller zoomFactor, take that one
+    double tempHeight = (bottomBorder - inputSize.height * reduceFactor / 2) / reduceFactor * 2; //vertical zoom center is always height/2
+    double vertZoomFactor = (double) (inputSize.height - tempHeight) / (inputSize.height - maxZoomedWindow.height) * 100;
+    
+    if (vertZoomFactor < zoomFactor) {
+        zoomFactor = vertZoomFactor;
+    }
+    
+    zoomFactor = area.zoomFactorFilter.update(zoomFactor);
+    
+    if (zoomFactor > 100.0) {
+        zoomFactor = 100.0;
+    } else if (zoomFactor < 0.0) {
+        zoomFactor = 0.0;
+    }
+    
+    zoomXPosition = (leftBorder + rightBorder) / 2;
+    zoomXPosition = area.zoomXPositionFilter.update(zoomXPosition);
+
+}
+
+//tries to put max 4 clusters
+void MotionEngine::cluster(Area &area, vector<Point> nonZeroPoints, DebugSink::Overlay *overlay) {
+    
+    //cast points into 2D floating point array
+    int sampleCount = (int) nonZeroPoints.size();
+    Mat points(sampleCount, 1, CV_32FC2);
+    for (int i = 0; i < sampleCount; i++) {
+        points.at<Point2f>(i) = nonZeroPoints.at(i);
+    }
+    
+    int clusterCount = MIN(4, sampleCount);
+    Mat centers, labels;
+    vector<Point2f> objects = area.objHandler.getObjects();
+    
+    if (overlay) {
+        overlay->objects = objects;
+    }
+    
+    if (clusterCount > 0) {
+        TermCriteria crit = TermCriteria( TermCriteria::EPS+TermCriteria::COUNT, 5, 1.0);
+        
+        kmeans(points, clusterCount, labels, crit, 3, KMEANS_PP_CENTERS, centers);
+        
+        objects = area.objHandler.update(centers);
+        
+        if (overlay) {
+            //centers and sample points (non zero points) for debugging
+            for (int i = 0; i < centers.rows; ++i) {
+                overlay->centers.push_back(centers.at<Point2f>(i));
+            }
+            overlay->samplePoints = nonZeroPoints;
+        }
+    }
+    
+    //draw circles around objects to thresholdImage, so later zoom frame detection will take them into account
+    //TODO: this is probably not the best way to interface the objects...
+    for (auto obj = objects.begin(); obj != objects.end(); ++obj) {
+        circle(area.thresholdImage, *obj, 30, Scalar(255), FILLED, LINE_AA);
+    }
+
+}
+
+void MotionEngine::trackObjects(Area &area, Result &result, DebugSink::Overlay *overlay) {
+    
+    //find non zero points
+    vector<Point> points;
+    findNonZero(area.thresholdImage, points);
+    
+    //try clustering
+    cluster(area, points, overlay);
+    
+    //calculate the bounding rectangle for all non zero points
+    //TODO: clumsy!
+    findNonZero(area.thresholdImage, points); //find non zero points again, as thresholdImage has been altered by cluster
+    
+    //bounding rectangle. If computed image is empty, take the whole picture
+    //with several areas, a calm one shows only its own part of the picture
+    Rect objectBoundingRectangle = Rect(0, 0, analysisSize.width, analysisSize.height);
+    if (areas.size() > 1) {
+        objectBoundingRectangle = area.maskRectangle;
+    }
+    if (points.size() > 0) {
+        objectBoundingRectangle = boundingRect(points);
+    }
+    
+    //between sweeps only the regions around the objects were analysed, so the zoom keeps what the last sweep saw
+    //otherwise it would jump between the whole motion and the predicted regions at the sweep interval
+    if (area.framesSinceSweep > 0) {
+        objectBoundingRectangle = points.size() > 0 ? objectBoundingRectangle | area.sweepRectangle : area.sweepRectangle;
+    } else {
+        area.sweepRectangle = objectBoundingRectangle;
+    }
+    
+    //calculate zoom factor
+    int cameraVerticalPosition = (int) inputSize.height / 2;
+    Size zoomedWindow = maxZoomedWindow;
+    
+    double zoomCenter = 0; //calculate only x position, as y position of camera is fixed
+    double zoomFactor = 0.0;  // zoomFaktor will be between 0 (no zoom) and 100 (max zoom)
+    
+    calcZoom(area, objectBoundingRectangle, zoomCenter, zoomFactor);
+    
+    //make zoomed window
+    zoomedWindow.width = (int)(inputSize.width - zoomFactor * (inputSize.width - maxZoomedWindow.width) / 100);
+    zoomedWindow.height = (int)(inputSize.height - zoomFactor * (inputSize.height - maxZoomedWindow.height) / 100);
+    
+    if (zoomedWindow.width > inputSize.width) {
+        zoomedWindow.width = inputSize.width;
+    }
+    if (zoomedWindow.height > inputSize.height) {
+        zoomedWindow.height = inputSize.height;
+    }
+    
+    int xx, yy; //top left corner of zoomed window
+    xx = (int)( zoomCenter / reduceFactor - zoomedWindow.width / 2 );
+    yy = cameraVerticalPosition - ( (int) zoomedWindow.height / 2 ); // fix vertical camera swing
+    
+    //limit against border of image
+    if (xx < 0) xx = 0;
+    if (yy < 0) yy = 0;
+    
+    int maxX = inputSize.width - zoomedWindow.width;
+    int maxY = inputSize.height - zoomedWindow.height;
+    
+    if (xx > maxX) xx = maxX;
+    if (yy > maxY) yy = maxY;
+    
+    result.crop = Rect(xx, yy, zoomedWindow.width, zoomedWindow.height);
+    result.zoomFactor = zoomFactor;
+    result.boundingRectangle = Rect(objectBoundingRectangle.tl() * (1 / reduceFactor), objectBoundingRectangle.br() * (1 / reduceFactor));
+    vector<Point2f> objects = area.objHandler.getObjects();
+    for (auto obj = objects.begin(); obj != objects.end(); ++obj) {
+        result.objects.push_back(*obj * (1 / reduceFactor));
+    }
+    
+    //collect debug information, drawing is done by the DebugSink
+    if (overlay) {
+        
+        int camY = (int) cameraVerticalPosition / 2;
+        
+        //center of camera (after inertia filtering)
+        overlay->zoomCenter = Point(zoomCenter, camY);
+        
+        overlay->boundingRectangle = objectBoundingRectangle;
+        
+        //zoom rectangle
+        Point tl(xx, yy);
+        Point br(xx + zoomedWindow.width, yy + zoomedWindow.height);
+        overlay->zoomRectangle = Rect(tl * reduceFactor, br * reduceFactor);
+        
+        overlay->regions = area.regions;
+    }
+
+}
+
+MotionEngine::Result MotionEngine::process(const Frame &inFrame, DebugSink::Overlay *overlay) {
+    return process(inFrame, Mat(), overlay);
+}
+
+MotionEngine::Result MotionEngine::process(const Mat &in, DebugSink::Overlay *overlay) {
+    return process(in, Mat(), overlay);
+}
+
+MotionEngine::Result MotionEngine::process(const Frame &inFrame, const Mat &motionMap, DebugSink::Overlay *overlay) {
+    return processAreas(inFrame, motionMap, overlay).front();
+}
+
+MotionEngine::Result MotionEngine::process(const Mat &in, const Mat &motionMap, DebugSink::Overlay *overlay) {
+    return processAreas(in, motionMap, overlay).front();
+}
+
+vector<MotionEngine::Result> MotionEngine::processAreas(const Frame &inFrame, const Mat &motionMap, DebugSink::Overlay *overlay) {
+    int type = CV_8UC3;
+    if (inFrame.format == PixelFormat::GRAY) {
+        type = CV_8UC1;
+    } else if (inFrame.format == PixelFormat::BGRA) {
+        type = CV_8UC4;
+    }
+    //only a header around the caller's buffer, no copy
+    Mat in(inFrame.height, inFrame.width, type, (void *) inFrame.data, inFrame.stride);
+    return processAreas(in, motionMap, overlay);
+}
+
+//choose the regions of the reduced frame to be analysed for one area
+void MotionEngine::selectRegions(Area &area, bool idle, bool compressedDomain, const Mat &motionMap) {
+    
+    area.regions.clear();
+    area.regionMoving.clear();
+    if (idle) {
+        //the codec saw no motion anywhere, no pixel work at all
+        area.framesSinceSweep = 0;
+        return;
+    }
+    
+    //analyse only around the predicted objects, unless a full sweep is due or a prediction lost its target
+    if (roiTracking and !area.targetLost and area.framesSinceSweep < FULL_SWEEP_INTERVAL) {
+        area.regions = area.objHandler.predictRegions(ROI_RADIUS, &area.regionMoving);
+    }
+    if (!area.regions.empty()) {
+        area.framesSinceSweep++;
+        return;
+    }
+    
+    //full sweep: the whole frame, the tiles active on the coarse level or the ones the codec saw moving
+    if (compressedDomain) {
+        //only the moving cells within the area, a cell counts if any of its pixels is unmasked
+        if (area.mask.data) {
+            if (area.mapMask.size() != motionMap.size()) {
+                resize(area.mask, area.mapMask, motionMap.size(), 0, 0, INTER_AREA);
+                threshold(area.mapMask, area.mapMask, 0, 255, THRESH_BINARY);
+            }
+            bitwise_and(motionMap, area.mapMask, area.tiles);
+        } else {
+            motionMap.copyTo(area.tiles);
+        }
+        dilate(area.tiles, area.tiles, Mat());
+        regionsFromTiles(area);
+    } else if (sweepMode == SweepMode::FULL) {
+        area.regions.push_back(Rect(0, 0, analysisSize.width, analysisSize.height));
+    } else {
+        findActiveRegions(area);
+    }
+    area.framesSinceSweep = 0;
+}
+
+//runs on a worker thread of the ResourceGovernor, the areas share nothing but read only images
+void MotionEngine::trackArea(void *context, size_t index) {
+    
+    AreaJob *job = (AreaJob *) context;
+    MotionEngine *engine = job->engine;
+    Area &area = *engine->areas[index];
+    Result &result = job->results[index];
+    
+    bool movingRegionsActive = engine->detectMotion(area);
+    //a lost target is only meaningful for predicted regions, a calm full frame is just a calm scene
+    area.targetLost = !movingRegionsActive and area.framesSinceSweep > 0;
+    
+    result.fullSweep = area.framesSinceSweep == 0;
+    result.regionCount = (int) area.regions.size();
+    
+    //search for movement in our thresholded image
+    engine->trackObjects(area, result, index == 0 ? job->overlay : nullptr);
+}
+
+//motionMap: optional coarse map of the codec's motion vectors, non zero where the codec saw motion
+//an empty map means there is no information for this frame (e.g. a key frame)
+vector<MotionEngine::Result> MotionEngine::processAreas(const Mat &in, const Mat &motionMap, DebugSink::Overlay *overlay) {
+    //the engine may run on any thread, OpenCV's thread pool must stay as it is meanwhile
+    ResourceGovernor::OpenCvScope openCvScope;
+    
+    Result untracked;
+    untracked.crop = Rect(0, 0, inputSize.width, inputSize.height);
+    untracked.boundingRectangle = untracked.crop;
+    vector<Result> results(areas.size(), untracked);
+    
+    //frames of another size are not tracked, the caller checks the size once
+    if (in.cols != inputSize.width or in.rows != inputSize.height) {
+        return results;
+    }
+    
+    bool compressedDomain = sweepMode == SweepMode::MOTION_VECTORS and !motionMap.empty();
+    
+    //the codec saw no motion anywhere: the last reduced frame still stands for this one, so it is not even reduced
+    //the next frame with motion is compared with the last reduced one
+    bool idle = compressedDomain and !grayImage2.empty() and countNonZero(motionMap) == 0;
+    if (!idle) {
+        reduce(in);
+    }
+    
+    //the very first frame has nothing to compare with
+    if (grayImage1.empty()) {
+        return results;
+    }
+    
+    //cheap, so done in sequence, the coarse level is shared
+    for (auto area = areas.begin(); area != areas.end(); ++area) {
+        selectRegions(**area, idle, compressedDomain, motionMap);
+    }
+    
+    differentiate();
+    
+    //masking, thresholding, clustering and zooming of the areas in parallel, as far as the recording allows
+    AreaJob job = { this, results.data(), overlay };
+    ResourceGovernor::shared().apply(areas.size(), &job, trackArea);
+    
+    return results;
+}
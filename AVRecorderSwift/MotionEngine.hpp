@@ -0,0 +1,149 @@
+//
+//  MotionEngine.hpp
+//  AVRecorderSwift
+//
+//  Created by Andreas Pohl on 19.10.26.
+//  Copyright © 2026 Andreas Pohl. All rights reserved.
+//
+
+#ifndef MotionEngine_hpp
+#define MotionEngine_hpp
+
+#include <stdio.h>
+#include <memory>
+
+#include "Filter.hpp"
+#include "ObjectHandler.hpp"
+#include "DebugSink.hpp"
+
+#include <opencv2/opencv.hpp>
+
+using namespace std;
+using namespace cv;
+
+//the motion tracking and zoom calculation, without any file handling
+//frames are pushed one by one in caller owned buffers, which are read in place and never copied
+//the result tells which part of the frame to cut out, cutting, scaling and encoding is up to the caller
+//a camera may cover several areas, each one with its own mask, tracking and zoom
+//decoding, reduction and frame differencing are shared, the areas are tracked in parallel
+class MotionEngine {
+
+public:
+    enum class PixelFormat {
+        GRAY, // 8 bit luma only, e.g. the Y plane of a NV12 buffer
+        BGR, // 8 bit per channel, 3 channels
+        BGRA // 8 bit per channel, 4 channels, e.g. a kCVPixelFormatType_32BGRA buffer
+    };
+    
+    //how a full sweep looks for motion
+    enum class SweepMode {
+        FULL, // difference the whole reduced frame
+        PYRAMID, // difference a coarse level first, then only the active tiles of the reduced frame, misses motion that keeps the coarse averages
+        MOTION_VECTORS // take the active tiles from the motion map of the codec, PYRAMID where there is none
+    };
+    
+    //a frame in a caller owned buffer, stride in bytes per row
+    struct Frame {
+        const unsigned char *data = nullptr;
+        int width = 0;
+        int height = 0;
+        size_t stride = 0;
+        PixelFormat format = PixelFormat::BGR;
+    };
+    
+    //tracking state after one frame, all coordinates in input frame pixels
+    struct Result {
+        Rect crop = Rect(0, 0, 0, 0); // zoom window to cut out of the frame
+        double zoomFactor = 0.0; // between 0 (no zoom) and 100 (max zoom)
+        Rect boundingRectangle = Rect(0, 0, 0, 0); // all motion and tracked objects
+        vector<Point2f> objects; // mature tracked objects
+        int regionCount = 0; // number of analysed regions
+        bool fullSweep = true; // false, if only the regions around predicted objects were analysed
+    };
+    
+    MotionEngine(int width, int height, int areaCount = 1);
+    
+    void setMask(const Mat &mask, int area = 0);
+    void setRoiTracking(bool on);
+    void setSweepMode(SweepMode mode);
+    
+    Result process(const Frame &frame, DebugSink::Overlay *overlay = nullptr);
+    Result process(const Mat &frame, DebugSink::Overlay *overlay = nullptr);
+    Result process(const Frame &frame, const Mat &motionMap, DebugSink::Overlay *overlay = nullptr);
+    Result process(const Mat &frame, const Mat &motionMap, DebugSink::Overlay *overlay = nullptr);
+    
+    //one result per area, the overlay shows the first area
+    vector<Result> processAreas(const Frame &frame, const Mat &motionMap, DebugSink::Overlay *overlay = nullptr);
+    vector<Result> processAreas(const Mat &frame, const Mat &motionMap, DebugSink::Overlay *overlay = nullptr);
+    
+    int getAreaCount();
+    Size getInputSize();
+    const Mat &getAnalysisFrame();
+
+private:
+    Size inputSize;
+    Size analysisSize;
+    Size maxZoomedWindow;
+    
+    bool roiTracking = false;
+    SweepMode sweepMode = SweepMode::FULL;
+    
+    //everything that is tracked separately for each area
+    struct Area {
+        //mask in the reduced frame and on the coarse pyramid level
+        Mat mask, coarseMask;
+        //thresholded difference image
+        Mat thresholdImage;
+        //active tiles of the area
+        Mat tiles;
+        //mask on the grid of the codec's motion map, made for the first map
+        Mat mapMask;
+        //bounding rectangle of the mask, the zoom window when the area is calm and there are several areas
+        Rect maskRectangle;
+        //bounding rectangle of the last full sweep, between sweeps the motion outside the regions is only known from it
+        Rect sweepRectangle;
+        
+        ObjectHandler objHandler;
+        
+        Filter leftBorderFilter;
+        Filter rightBorderFilter;
+        Filter bottomBorderFilter;
+        Filter zoomXPositionFilter;
+        Filter zoomFactorFilter;
+        
+        vector<Rect> regions;
+        //for predicted regions: true, if the object of the region is moving
+        vector<bool> regionMoving;
+        int framesSinceSweep = 0;
+        bool targetLost = true;
+        
+        Area(Size analysisSize);
+    };
+    vector<unique_ptr<Area>> areas;
+    
+    //the reduced input frame and the grayscale images of the previous and the actual frame
+    Mat frame, grayImage1, grayImage2;
+    //difference image, shared by all areas, only valid within their regions
+    Mat differenceImage;
+    //coarse level of the previous and the actual frame and their thresholded difference, shared by all areas
+    //valid: computed for the gray image, the difference is valid along with coarse2
+    Mat coarse1, coarse2, coarseDifference;
+    bool coarse1Valid = false;
+    bool coarse2Valid = false;
+    
+    void reduce(const Mat &in);
+    void selectRegions(Area &area, bool idle, bool compressedDomain, const Mat &motionMap);
+    void differentiate();
+    bool detectMotion(Area &area);
+    void findActiveRegions(Area &area);
+    void regionsFromTiles(Area &area);
+    void cluster(Area &area, vector<Point> nonZeroPoints, DebugSink::Overlay *overlay);
+    void calcZoom(Area &area, Rect boundingRectangle, double &zoomXPosition, double &zoomFactor);
+    void trackObjects(Area &area, Result &result, DebugSink::Overlay *overlay);
+    
+    //one area of a frame, run by the ResourceGovernor
+    struct AreaJob;
+    static void trackArea(void *context, size_t index);
+};
+
+#endif /* MotionEngine_hpp */
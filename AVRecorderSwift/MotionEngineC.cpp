@@ -0,0 +1,134 @@
+//
+//  MotionEngineC.cpp
+//  AVRecorderSwift
+//
+//  Created by Andreas Pohl on 19.10.26.
+//  Copyright © 2026 Andreas Pohl. All rights reserved.
+//
+
+#include "MotionEngineC.h"
+#include "MotionEngine.hpp"
+
+#include <iostream>
+
+struct MotionEngineOpaque {
+    MotionEngine engine;
+    MotionEngineOpaque(int width, int height) : engine(width, height) {}
+};
+
+static MotionRect toMotionRect(Rect r) {
+    MotionRect out = { r.x, r.y, r.width, r.height };
+    return out;
+}
+
+//no C++ exception (cv::Exception, bad_alloc, ...) may cross the C interface
+MotionEngineRef MotionEngineCreate(int32_t width, int32_t height) {
+    if (width <= 0 or height <= 0) {
+        return nullptr;
+    }
+    try {
+        return new MotionEngineOpaque(width, height);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void MotionEngineRelease(MotionEngineRef engine) {
+    delete engine;
+}
+
+int32_t MotionEngineSetMask(MotionEngineRef engine, const uint8_t *mask, int32_t width, int32_t height, size_t stride) {
+    if (!engine) {
+        return -1;
+    }
+    try {
+        if (!mask) {
+            engine->engine.setMask(Mat());
+        } else {
+            engine->engine.setMask(Mat(height, width, CV_8UC1, (void *) mask, stride));
+        }
+    } catch (const cv::Exception &e) {
+        cout << "MotionEngineSetMask: " << e.what() << "\n";
+        return -1;
+    } catch (...) {
+        return -1;
+    }
+    return 0;
+}
+
+void MotionEngineSetRoiTracking(MotionEngineRef engine, int32_t on) {
+    if (engine) {
+        engine->engine.setRoiTracking(on != 0);
+    }
+}
+
+void MotionEngineSetSweepMode(MotionEngineRef engine, MotionSweepMode mode) {
+    if (!engine) {
+        return;
+    }
+    if (mode == MotionSweepModeFull) {
+        engine->engine.setSweepMode(MotionEngine::SweepMode::FULL);
+    } else if (mode == MotionSweepModeMotionVectors) {
+        engine->engine.setSweepMode(MotionEngine::SweepMode::MOTION_VECTORS);
+    } else {
+        engine->engine.setSweepMode(MotionEngine::SweepMode::PYRAMID);
+    }
+}
+
+int32_t MotionEngineProcessFrame(MotionEngineRef engine, const uint8_t *data, int32_t width, int32_t height, size_t stride,
+                                 MotionPixelFormat format, MotionResult *result) {
+    return MotionEngineProcessFrameWithMotionMap(engine, data, width, height, stride, format, nullptr, 0, 0, 0, result);
+}
+
+int32_t MotionEngineProcessFrameWithMotionMap(MotionEngineRef engine, const uint8_t *data, int32_t width, int32_t height, size_t stride,
+                                              MotionPixelFormat format, const uint8_t *motionMap, int32_t mapWidth, int32_t mapHeight,
+                                              size_t mapStride, MotionResult *result) {
+    if (!engine or !data or !result) {
+        return -1;
+    }
+    
+    //the engine only tracks frames of the size it was created with
+    Size inputSize = engine->engine.getInputSize();
+    if (width != inputSize.width or height != inputSize.height) {
+        return -1;
+    }
+    
+    MotionEngine::Frame frame;
+    frame.data = data;
+    frame.width = width;
+    frame.height = height;
+    frame.stride = stride;
+    frame.format = MotionEngine::PixelFormat::BGR;
+    if (format == MotionPixelFormatGray) {
+        frame.format = MotionEngine::PixelFormat::GRAY;
+    } else if (format == MotionPixelFormatBGRA) {
+        frame.format = MotionEngine::PixelFormat::BGRA;
+    }
+    
+    Mat map;
+    if (motionMap and mapWidth > 0 and mapHeight > 0) {
+        map = Mat(mapHeight, mapWidth, CV_8UC1, (void *) motionMap, mapStride);
+    }
+    
+    MotionEngine::Result r;
+    try {
+        r = engine->engine.process(frame, map);
+    } catch (const cv::Exception &e) {
+        cout << "MotionEngineProcessFrame: " << e.what() << "\n";
+        return -1;
+    } catch (...) {
+        return -1;
+    }
+    
+    result->crop = toMotionRect(r.crop);
+    result->zoomFactor = r.zoomFactor;
+    result->boundingRectangle = toMotionRect(r.boundingRectangle);
+    result->objectCount = (int32_t) MIN(r.objects.size(), (size_t) MOTION_MAX_OBJECTS);
+    for (int i = 0; i < result->objectCount; i++) {
+        result->objects[i].x = r.objects[i].x;
+        result->objects[i].y = r.objects[i].y;
+    }
+    result->regionCount = r.regionCount;
+    result->fullSweep = r.fullSweep ? 1 : 0;
+    return 0;
+}
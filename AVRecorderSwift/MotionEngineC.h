@@ -0,0 +1,83 @@
+//
+//  MotionEngineC.h
+//  AVRecorderSwift
+//
+//  Created by Andreas Pohl on 19.10.26.
+//  Copyright © 2026 Andreas Pohl. All rights reserved.
+//
+
+//C interface of the MotionEngine, for embedding the motion tracking into other capture and encode pipelines
+//frames are passed in caller owned buffers, which are only read during the call and never copied or kept
+
+#ifndef MotionEngineC_h
+#define MotionEngineC_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MOTION_MAX_OBJECTS 16
+
+typedef struct MotionEngineOpaque *MotionEngineRef;
+
+typedef enum {
+    MotionPixelFormatGray = 0, // 8 bit luma only, e.g. the Y plane of a NV12 buffer
+    MotionPixelFormatBGR = 1, // 8 bit per channel, 3 channels
+    MotionPixelFormatBGRA = 2 // 8 bit per channel, 4 channels
+} MotionPixelFormat;
+
+typedef enum {
+    MotionSweepModeFull = 0,
+    MotionSweepModePyramid = 1,
+    MotionSweepModeMotionVectors = 2 // needs motion maps, see MotionEngineProcessFrameWithMotionMap
+} MotionSweepMode;
+
+typedef struct {
+    int32_t x, y, width, height;
+} MotionRect;
+
+typedef struct {
+    float x, y;
+} MotionPoint;
+
+//tracking state after one frame, all coordinates in input frame pixels
+typedef struct {
+    MotionRect crop; // zoom window to cut out of the frame
+    double zoomFactor; // between 0 (no zoom) and 100 (max zoom)
+    MotionRect boundingRectangle; // all motion and tracked objects
+    int32_t objectCount; // number of valid entries in objects
+    MotionPoint objects[MOTION_MAX_OBJECTS]; // mature tracked objects
+    int32_t regionCount; // number of analysed regions
+    int32_t fullSweep; // 0, if only the regions around predicted objects were analysed
+} MotionResult;
+
+//returns NULL if the size is invalid
+MotionEngineRef MotionEngineCreate(int32_t width, int32_t height);
+void MotionEngineRelease(MotionEngineRef engine);
+
+//8 bit mask in any resolution, non zero where motion is of interest. NULL removes the mask
+//all functions returning int32_t return 0 on success and -1 on failure
+int32_t MotionEngineSetMask(MotionEngineRef engine, const uint8_t *mask, int32_t width, int32_t height, size_t stride);
+//off by default
+void MotionEngineSetRoiTracking(MotionEngineRef engine, int32_t on);
+//MotionSweepModeFull by default
+void MotionEngineSetSweepMode(MotionEngineRef engine, MotionSweepMode mode);
+
+int32_t MotionEngineProcessFrame(MotionEngineRef engine, const uint8_t *data, int32_t width, int32_t height, size_t stride,
+                                 MotionPixelFormat format, MotionResult *result);
+
+//returns -1, if the frame size does not match the size of the engine
+//motionMap: coarse grid over the whole frame, non zero where the encoder / decoder saw motion, e.g. from its motion vectors
+//NULL means no information for this frame (e.g. a key frame)
+int32_t MotionEngineProcessFrameWithMotionMap(MotionEngineRef engine, const uint8_t *data, int32_t width, int32_t height, size_t stride,
+                                              MotionPixelFormat format, const uint8_t *motionMap, int32_t mapWidth, int32_t mapHeight,
+                                              size_t mapStride, MotionResult *result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MotionEngineC_h */
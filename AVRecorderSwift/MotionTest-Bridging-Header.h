@@ -11,5 +11,6 @@
 #define MotionTest_Bridging_Header_h
 
 #import "MotionWrapper.h"
+#import "MotionEngineC.h"
 
 #endif /* MotionTest_Bridging_Header_h */
@@ -0,0 +1,221 @@
+//
+//  MotionVectorReader.cpp
+//  AVRecorderSwift
+//
+//  Created by Andreas Pohl on 19.10.26.
+//  Copyright © 2026 Andreas Pohl. All rights reserved.
+//
+
+#include "MotionVectorReader.hpp"
+#include "ResourceGovernor.hpp"
+
+#include <iostream>
+
+//cell size of the motion map in input pixels, the macroblock size of H.264
+const static int MACROBLOCK_SIZE = 16;
+
+//motion vectors shorter than this (in input pixels) are taken as noise of the encoder
+const static double MIN_MOTION = 1.0;
+
+//frame rate, if the movie does not tell
+const static double DEFAULT_FPS = 25.0;
+
+MotionVectorReader::MotionVectorReader() {
+}
+
+MotionVectorReader::~MotionVectorReader() {
+    release();
+}
+
+bool MotionVectorReader::open(const string &fileName) {
+    release();
+    
+    if (avformat_open_input(&formatContext, fileName.c_str(), nullptr, nullptr) < 0) {
+        cout << "MotionVectorReader: could not open " << fileName << "\n";
+        return false;
+    }
+    if (avformat_find_stream_info(formatContext, nullptr) < 0) {
+        cout << "MotionVectorReader: no stream info in " << fileName << "\n";
+        release();
+        return false;
+    }
+    
+    //the decoder became const with FFmpeg 5
+#if LIBAVFORMAT_VERSION_MAJOR >= 59
+    const AVCodec *codec = nullptr;
+#else
+    AVCodec *codec = nullptr;
+#endif
+    streamIndex = av_find_best_stream(formatContext, AVMEDIA_TYPE_VIDEO, -1, -1, &codec, 0);
+    if (streamIndex < 0 or !codec) {
+        cout << "MotionVectorReader: no video stream in " << fileName << "\n";
+        release();
+        return false;
+    }
+    
+    codecContext = avcodec_alloc_context3(codec);
+    avcodec_parameters_to_context(codecContext, formatContext->streams[streamIndex]->codecpar);
+    
+    //decode on as many threads as the ResourceGovernor allows now, the decoder cannot change it later
+    codecContext->thread_count = ResourceGovernor::shared().getWorkerLimit();
+    codecContext->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+    
+    //let the decoder attach the motion vectors to the frames
+    AVDictionary *options = nullptr;
+    av_dict_set(&options, "flags2", "+export_mvs", 0);
+    int result = avcodec_open2(codecContext, codec, &options);
+    av_dict_free(&options);
+    if (result < 0) {
+        cout << "MotionVectorReader: could not open decoder\n";
+        release();
+        return false;
+    }
+    
+    avFrame = av_frame_alloc();
+    packet = av_packet_alloc();
+    draining = false;
+    return true;
+}
+
+void MotionVectorReader::release() {
+    if (swsContext) {
+        sws_freeContext(swsContext);
+        swsContext = nullptr;
+    }
+    av_packet_free(&packet);
+    av_frame_free(&avFrame);
+    avcodec_free_context(&codecContext);
+    avformat_close_input(&formatContext);
+    streamIndex = -1;
+}
+
+//the average frame rate, the base frame rate if the container does not know it, DEFAULT_FPS if neither is known
+double MotionVectorReader::getFps() {
+    if (!formatContext or streamIndex < 0) {
+        return 0;
+    }
+    AVStream *stream = formatContext->streams[streamIndex];
+    AVRational rates[] = { stream->avg_frame_rate, stream->r_frame_rate };
+    for (AVRational rate : rates) {
+        if (rate.num > 0 and rate.den > 0) {
+            return av_q2d(rate);
+        }
+    }
+    return DEFAULT_FPS;
+}
+
+//from the container, estimated from the duration if the container does not know
+double MotionVectorReader::getFrameCount() {
+    if (!formatContext or streamIndex < 0) {
+        return 0;
+    }
+    AVStream *stream = formatContext->streams[streamIndex];
+    if (stream->nb_frames > 0) {
+        return (double) stream->nb_frames;
+    }
+    if (formatContext->duration > 0) {
+        return (double) formatContext->duration / AV_TIME_BASE * getFps();
+    }
+    return 0;
+}
+
+//receive the next decoded frame, feeding packets as needed
+bool MotionVectorReader::decodeNext() {
+    while (true) {
+        int result = avcodec_receive_frame(codecContext, avFrame);
+        if (result == 0) {
+            return true;
+        }
+        if (result != AVERROR(EAGAIN) or draining) {
+            return false;
+        }
+        
+        if (av_read_frame(formatContext, packet) < 0) {
+            //end of file, flush the frames still in the decoder
+            draining = true;
+            avcodec_send_packet(codecContext, nullptr);
+            continue;
+        }
+        if (packet->stream_index == streamIndex) {
+            avcodec_send_packet(codecContext, packet);
+        }
+        av_packet_unref(packet);
+    }
+}
+
+//the frame as BGR and its motion map, an empty motion map means the codec has no information (e.g. key frames)
+//in the motion map, the cells of moving blocks and of intra coded blocks are non zero
+bool MotionVectorReader::read(Mat &frame, Mat &motionMap) {
+    if (!codecContext or !decodeNext()) {
+        return false;
+    }
+    
+    int width = avFrame->width;
+    int height = avFrame->height;
+    //the frames are cut out and written, so the chroma is interpolated like VideoCapture does
+    swsContext = sws_getCachedContext(swsContext, width, height, (AVPixelFormat) avFrame->format,
+                                      width, height, AV_PIX_FMT_BGR24, SWS_BILINEAR, nullptr, nullptr, nullptr);
+    if (!swsContext) {
+        cout << "MotionVectorReader: cannot convert pixel format " << avFrame->format << "\n";
+        av_frame_unref(avFrame);
+        return false;
+    }
+    frame.create(height, width, CV_8UC3);
+    uint8_t *destination[1] = { frame.data };
+    int destinationStride[1] = { (int) frame.step };
+    sws_scale(swsContext, avFrame->data, avFrame->linesize, 0, height, destination, destinationStride);
+    
+    buildMotionMap(motionMap);
+    
+    av_frame_unref(avFrame);
+    return true;
+}
+
+void MotionVectorReader::buildMotionMap(Mat &motionMap) {
+    AVFrameSideData *sideData = av_frame_get_side_data(avFrame, AV_FRAME_DATA_MOTION_VECTORS);
+    
+    //intra coded frames carry no motion vectors, codecs without export support never do
+    if (!sideData or avFrame->pict_type == AV_PICTURE_TYPE_I) {
+        motionMap.release();
+        return;
+    }
+    
+    int cols = (avFrame->width + MACROBLOCK_SIZE - 1) / MACROBLOCK_SIZE;
+    int rows = (avFrame->height + MACROBLOCK_SIZE - 1) / MACROBLOCK_SIZE;
+    motionMap.create(rows, cols, CV_8UC1);
+    motionMap.setTo(Scalar(0));
+    coverage.create(rows, cols, CV_8UC1);
+    coverage.setTo(Scalar(0));
+    
+    const AVMotionVector *vectors = (const AVMotionVector *) sideData->data;
+    int count = (int) (sideData->size / sizeof(AVMotionVector));
+    
+    for (int i = 0; i < count; i++) {
+        const AVMotionVector &mv = vectors[i];
+        
+        //the cells of the block, dst_x / dst_y is the block center
+        int x0 = MAX(0, (mv.dst_x - mv.w / 2) / MACROBLOCK_SIZE);
+        int y0 = MAX(0, (mv.dst_y - mv.h / 2) / MACROBLOCK_SIZE);
+        int x1 = MIN(cols - 1, (mv.dst_x + mv.w / 2 - 1) / MACROBLOCK_SIZE);
+        int y1 = MIN(rows - 1, (mv.dst_y + mv.h / 2 - 1) / MACROBLOCK_SIZE);
+        if (x0 > x1 or y0 > y1) {
+            continue;
+        }
+        Rect cells(x0, y0, x1 - x0 + 1, y1 - y0 + 1);
+        coverage(cells).setTo(Scalar(255));
+        
+        double dx = mv.dst_x - mv.src_x;
+        double dy = mv.dst_y - mv.src_y;
+        if (mv.motion_scale > 0) {
+            dx = (double) mv.motion_x / mv.motion_scale;
+            dy = (double) mv.motion_y / mv.motion_scale;
+        }
+        if (dx * dx + dy * dy >= MIN_MOTION * MIN_MOTION) {
+            motionMap(cells).setTo(Scalar(255));
+        }
+    }
+    
+    //cells without any vector are intra coded: the encoder found nothing to predict them from
+    //that is what an object entering the scene looks like, so they count as motion
+    motionMap.setTo(Scalar(255), coverage == 0);
+}
@@ -0,0 +1,58 @@
+//
+//  MotionVectorReader.hpp
+//  AVRecorderSwift
+//
+//  Created by Andreas Pohl on 19.10.26.
+//  Copyright © 2026 Andreas Pohl. All rights reserved.
+//
+
+#ifndef MotionVectorReader_hpp
+#define MotionVectorReader_hpp
+
+#include <stdio.h>
+
+#include <opencv2/opencv.hpp>
+
+#include <string>
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+#include <libavutil/frame.h>
+#include <libavutil/motion_vector.h>
+#include <libswscale/swscale.h>
+}
+
+using namespace std;
+using namespace cv;
+
+//decodes a movie with FFmpeg and exports the motion vectors of the codec along with each frame
+//the motion vectors are turned into a coarse motion map, one cell per macroblock, non zero where the codec saw motion
+class MotionVectorReader {
+    
+public:
+    MotionVectorReader();
+    ~MotionVectorReader();
+    
+    bool open(const string &fileName);
+    bool read(Mat &frame, Mat &motionMap);
+    double getFps();
+    double getFrameCount();
+    void release();
+    
+private:
+    AVFormatContext *formatContext = nullptr;
+    AVCodecContext *codecContext = nullptr;
+    SwsContext *swsContext = nullptr;
+    AVFrame *avFrame = nullptr;
+    AVPacket *packet = nullptr;
+    int streamIndex = -1;
+    bool draining = false;
+    //cells covered by any motion vector, the others are intra coded
+    Mat coverage;
+    
+    bool decodeNext();
+    void buildMotionMap(Mat &motionMap);
+};
+
+#endif /* MotionVectorReader_hpp */
@@ -9,7 +9,22 @@
 #pragma once
 
 #import <Foundation/Foundation.h>
+
+//how a full sweep looks for motion, see Motion::SweepMode
+typedef NS_ENUM(NSInteger, MotionWrapperSweepMode) {
+    MotionWrapperSweepModeFull,
+    MotionWrapperSweepModePyramid,
+    MotionWrapperSweepModeMotionVectors
+};
+
 @interface MotionWrapper : NSObject
-- (void)processVideoWrapped:(NSString *)videoFileName;
+- (NSInteger)processVideoWrapped:(NSString *)videoFileName;
 - (void)processVideoDebug:(NSString *)videoFileName;
+- (void)processVideoDebugImages:(NSString *)videoFileName;
+//the motion processing backs off while recording
++ (void)setRecording:(BOOL)recording;
+//analyse only around the tracked objects between full sweeps, for all following videos
++ (void)setRoiTracking:(BOOL)on;
+//for all following videos
++ (void)setSweepMode:(MotionWrapperSweepMode)mode;
 @end
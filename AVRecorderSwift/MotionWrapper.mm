@@ -8,14 +8,41 @@
 
 #import "MotionWrapper.h"
 #include "Motion.hpp"
+#include "ResourceGovernor.hpp"
 @implementation MotionWrapper
-- (void)processVideoWrapped:(NSString *)videoFileName {
+- (NSInteger)processVideoWrapped:(NSString *)videoFileName {
     Motion motion;
-    motion.processVideo([videoFileName cStringUsingEncoding:NSUTF8StringEncoding]);
+    return motion.processVideo([videoFileName cStringUsingEncoding:NSUTF8StringEncoding]);
 }
 - (void)processVideoDebug:(NSString *)videoFileName {
     Motion motion;
     motion.setTest();
     motion.processVideo([videoFileName cStringUsingEncoding:NSUTF8StringEncoding]);
 }
+- (void)processVideoDebugImages:(NSString *)videoFileName {
+    Motion motion;
+    motion.setTest(true);
+    motion.processVideo([videoFileName cStringUsingEncoding:NSUTF8StringEncoding]);
+}
++ (void)setRecording:(BOOL)recording {
+    ResourceGovernor::shared().setRecording(recording);
+}
++ (void)setRoiTracking:(BOOL)on {
+    Motion motion;
+    motion.setRoiTracking(on);
+}
++ (void)setSweepMode:(MotionWrapperSweepMode)mode {
+    Motion motion;
+    switch (mode) {
+        case MotionWrapperSweepModePyramid:
+            motion.setSweepMode(Motion::SweepMode::PYRAMID);
+            break;
+        case MotionWrapperSweepModeMotionVectors:
+            motion.setSweepMode(Motion::SweepMode::MOTION_VECTORS);
+            break;
+        default:
+            motion.setSweepMode(Motion::SweepMode::FULL);
+            break;
+    }
+}
 @end
@@ -12,6 +12,8 @@ const int ISOLATION = 60; //distance over which separate objects are recognized
 const int BORDER_ZONE = 10; //no storing of objects near the image borders (object may have left the frame)
 const int TOO_YOUNG = 10; //ignore objects younger than TOO_YOUNG frames / lifes
 const int MAX_LIFES = 900; //maximum frames (aka lifes) an object can accumulate (and can live withouth moving) (900 / 15 = 60 seconds)
+const double VELOCITY_SMOOTHING = 0.5; //weight of the latest movement in the velocity of an object
+const double MIN_SPEED = 0.5; //slower objects count as standing still, a missing motion around them does not mean they are lost
 
 void ObjectHandler::matToVector(Mat in, vector<Object> &out) {
     for (int i = 0; i < in.rows; i++) {
@@ -81,6 +83,8 @@ vector<Point2f> ObjectHandler::update(Mat clusterCenters) {
                 //inherit lifes from overlapping object, if larger than own
                 if ((*object).lifes >= (*center).lifes - 1) {
                     (*center).lifes = (*object).lifes + 2; //increase lifes by 2, as later 1 is reduced for general aging
+                    //inherit velocity as well, smoothed with the actual movement
+                    (*center).velocity = ((*center).point - (*object).point) * VELOCITY_SMOOTHING + (*object).velocity * (1 - VELOCITY_SMOOTHING);
                     if ((*object).lifes > MAX_LIFES) {
                         (*object).lifes = MAX_LIFES; //limit lifes, so non moving objects are removed after MAX_LIFES
                     }
@@ -117,3 +121,30 @@ vector<Point2f> ObjectHandler::getObjects() {
     
     return objectPoints;
 }
+
+//regions around the predicted next positions of the older objects, enlarged by their velocity and clipped to the image
+//moving: optional, tells for every region whether its object is moving
+vector<Rect> ObjectHandler::predictRegions(int radius, vector<bool> *moving) {
+    vector<Rect> regions;
+    if (moving) {
+        moving->clear();
+    }
+    Rect image(0, 0, width, height);
+    
+    for (auto object = objects.begin(); object != objects.end(); ++object) {
+        if ((*object).lifes > TOO_YOUNG) {
+            Point2f predicted = (*object).point + (*object).velocity;
+            int rx = radius + (int) abs((*object).velocity.x);
+            int ry = radius + (int) abs((*object).velocity.y);
+            Rect region = Rect((int) predicted.x - rx, (int) predicted.y - ry, 2 * rx, 2 * ry) & image;
+            if (region.area() > 0) {
+                regions.push_back(region);
+                if (moving) {
+                    moving->push_back(norm((*object).velocity) > MIN_SPEED);
+                }
+            }
+        }
+    }
+    
+    return regions;
+}
@@ -25,12 +25,14 @@ public:
     ObjectHandler(int width, int height);
     vector<Point2f> update(Mat centers);
     vector<Point2f> getObjects();
+    vector<Rect> predictRegions(int radius, vector<bool> *moving = nullptr);
     
 private:
     
     struct Object {
         Point2f point = {0, 0}; // center of the object
         int lifes = 1; // lifes (in number of frames) of the object, grows, when object is moving, shrinks, when object is static
+        Point2f velocity = {0, 0}; // smoothed movement per frame, used to predict the next position
     };
     
     vector<Object> objects;
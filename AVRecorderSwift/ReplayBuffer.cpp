@@ -0,0 +1,219 @@
+//
+//  ReplayBuffer.cpp
+//  AVRecorderSwift
+//
+//  Created by Andreas Pohl on 19.10.26.
+//  Copyright © 2026 Andreas Pohl. All rights reserved.
+//
+
+#include "ReplayBuffer.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <string.h>
+
+//upper limit of the bytes of the buffered packets, older packets are dropped earlier if it is exceeded
+const static size_t MAX_REPLAY_BYTES = 64 * 1024 * 1024;
+
+//slots per expected frame of the window, the frame rate of the camera may be higher than the one given
+const static int RING_HEADROOM = 2;
+
+//time base of the encoder and the saved movie, the QuickTime convention. MPEG-4 allows at most 65535
+const static int TIME_SCALE = 600;
+
+//bit rate of the replay, about the one of the processed output
+const static int64_t REPLAY_BIT_RATE = 6000000;
+
+ReplayBuffer::ReplayBuffer(int inWidth, int inHeight, double inFps, int inSeconds) {
+    width = inWidth;
+    height = inHeight;
+    fps = inFps > 0 ? inFps : 25;
+    seconds = inSeconds;
+    
+    //one key frame per second, one more second in the ring so the window can start at a key frame
+    ring.resize(MAX((size_t) 1, (size_t) ((seconds + 1) * fps * RING_HEADROOM)));
+    
+    if (!openEncoder()) {
+        cout << "ReplayBuffer: ERROR OPENING ENCODER\n";
+    }
+}
+
+ReplayBuffer::~ReplayBuffer() {
+    if (swsContext) {
+        sws_freeContext(swsContext);
+    }
+    av_packet_free(&avPacket);
+    av_frame_free(&avFrame);
+    avcodec_free_context(&encoder);
+}
+
+//prefer the hardware encoder, then any H.264 encoder, then MPEG-4 which every FFmpeg build has
+bool ReplayBuffer::openEncoder() {
+    const char *names[] = { "h264_videotoolbox", "libx264", "mpeg4" };
+    
+    for (const char *name : names) {
+        const AVCodec *codec = avcodec_find_encoder_by_name(name);
+        if (!codec) {
+            continue;
+        }
+        encoder = avcodec_alloc_context3(codec);
+        encoder->width = width;
+        encoder->height = height;
+        encoder->pix_fmt = AV_PIX_FMT_YUV420P;
+        encoder->time_base = AVRational{ 1, TIME_SCALE };
+        encoder->framerate = AVRational{ (int) (fps + 0.5), 1 };
+        encoder->gop_size = (int) (fps + 0.5);
+        encoder->max_b_frames = 0; //keeps packets in presentation order
+        encoder->bit_rate = REPLAY_BIT_RATE;
+        encoder->flags |= AV_CODEC_FLAG_GLOBAL_HEADER; //parameter sets go into the mp4 header
+        
+        if (avcodec_open2(encoder, codec, nullptr) == 0) {
+            cout << "ReplayBuffer encoding with " << name << "\n";
+            avFrame = av_frame_alloc();
+            avFrame->width = width;
+            avFrame->height = height;
+            avFrame->format = AV_PIX_FMT_YUV420P;
+            av_frame_get_buffer(avFrame, 0);
+            avPacket = av_packet_alloc();
+            return true;
+        }
+        avcodec_free_context(&encoder);
+    }
+    return false;
+}
+
+//encode one zoomed frame (BGR or BGRA, width x height) and keep its packet
+void ReplayBuffer::push(const Mat &frame, double timestamp) {
+    if (!encoder or frame.cols != width or frame.rows != height) {
+        return;
+    }
+    
+    AVPixelFormat sourceFormat = frame.channels() == 4 ? AV_PIX_FMT_BGRA : AV_PIX_FMT_BGR24;
+    swsContext = sws_getCachedContext(swsContext, width, height, sourceFormat, width, height, AV_PIX_FMT_YUV420P,
+                                      SWS_POINT, nullptr, nullptr, nullptr);
+    av_frame_make_writable(avFrame);
+    const uint8_t *source[1] = { frame.data };
+    int sourceStride[1] = { (int) frame.step };
+    sws_scale(swsContext, source, sourceStride, 0, height, avFrame->data, avFrame->linesize);
+    
+    //the capture time, not the frame count, as frames may have been dropped on the way
+    if (startTime < 0) {
+        startTime = timestamp;
+    }
+    int64_t pts = (int64_t) ((timestamp - startTime) * TIME_SCALE + 0.5);
+    if (pts <= lastPts) {
+        pts = lastPts + 1;
+    }
+    lastPts = pts;
+    avFrame->pts = pts;
+    
+    if (avcodec_send_frame(encoder, avFrame) < 0) {
+        return;
+    }
+    while (avcodec_receive_packet(encoder, avPacket) == 0) {
+        store(avPacket);
+        av_packet_unref(avPacket);
+    }
+}
+
+//copy the packet into the next slot of the ring, the slots of dropped packets are reused
+void ReplayBuffer::store(AVPacket *packet) {
+    lock_guard<mutex> lock(ringMutex);
+    
+    //the window holds more frames than there are slots: grow, the oldest packet first again
+    if (count == ring.size()) {
+        rotate(ring.begin(), ring.begin() + first, ring.end());
+        first = 0;
+        ring.resize(ring.size() * 2);
+    }
+    
+    Packet &slot = ring[(first + count) % ring.size()];
+    slot.data.assign(packet->data, packet->data + packet->size); //reuses the capacity of the slot
+    bytes += slot.data.size();
+    slot.pts = packet->pts;
+    slot.key = (packet->flags & AV_PKT_FLAG_KEY) != 0;
+    count++;
+    
+    //one second more than the window, so the window can start at a key frame
+    int64_t window = (int64_t) (seconds + 1) * TIME_SCALE;
+    while (count > 1 and slot.pts - ring[first].pts > window) {
+        dropOldest();
+    }
+    
+    //keep the memory bounded, even for high bit rates
+    while (bytes > MAX_REPLAY_BYTES and count > 1) {
+        dropOldest();
+    }
+}
+
+//the slot keeps its buffer, it is overwritten in place when the ring comes round
+void ReplayBuffer::dropOldest() {
+    bytes -= ring[first].data.size();
+    first = (first + 1) % ring.size();
+    count--;
+}
+
+//write the buffered window, starting at its oldest key frame, into a movie file (container from the file extension)
+bool ReplayBuffer::save(const string &fileName) {
+    if (!encoder) {
+        return false;
+    }
+    
+    //take a copy, so pushing goes on while the file is written
+    vector<Packet> packets;
+    {
+        lock_guard<mutex> lock(ringMutex);
+        size_t start = 0;
+        while (start < count and !ring[(first + start) % ring.size()].key) {
+            start++;
+        }
+        for (size_t i = start; i < count; i++) {
+            packets.push_back(ring[(first + i) % ring.size()]);
+        }
+    }
+    if (packets.empty()) {
+        cout << "ReplayBuffer: nothing to save\n";
+        return false;
+    }
+    
+    AVFormatContext *output = nullptr;
+    if (avformat_alloc_output_context2(&output, nullptr, nullptr, fileName.c_str()) < 0) {
+        cout << "ReplayBuffer: ERROR OPENING OUTPUT " << fileName << "\n";
+        return false;
+    }
+    AVStream *stream = avformat_new_stream(output, nullptr);
+    avcodec_parameters_from_context(stream->codecpar, encoder);
+    stream->time_base = encoder->time_base;
+    
+    bool success = avio_open(&output->pb, fileName.c_str(), AVIO_FLAG_WRITE) >= 0
+        and avformat_write_header(output, nullptr) >= 0;
+    
+    int64_t firstPts = packets.front().pts;
+    int64_t frameDuration = (int64_t) (TIME_SCALE / fps + 0.5);
+    AVPacket *packet = av_packet_alloc();
+    for (auto p = packets.begin(); success and p != packets.end(); ++p) {
+        av_new_packet(packet, (int) p->data.size());
+        memcpy(packet->data, p->data.data(), p->data.size());
+        packet->pts = p->pts - firstPts;
+        packet->dts = packet->pts;
+        //until the next frame, a dropped frame makes the one before last longer
+        packet->duration = p + 1 != packets.end() ? (p + 1)->pts - p->pts : frameDuration;
+        packet->flags = p->key ? AV_PKT_FLAG_KEY : 0;
+        packet->stream_index = stream->index;
+        av_packet_rescale_ts(packet, encoder->time_base, stream->time_base);
+        success = av_interleaved_write_frame(output, packet) >= 0;
+        av_packet_unref(packet);
+    }
+    av_packet_free(&packet);
+    
+    if (success) {
+        av_write_trailer(output);
+    }
+    avio_closep(&output->pb);
+    avformat_free_context(output);
+    
+    if (!success) {
+        cout << "ReplayBuffer: ERROR WRITING " << fileName << "\n";
+    }
+    return success;
+}
@@ -0,0 +1,76 @@
+//
+//  ReplayBuffer.hpp
+//  AVRecorderSwift
+//
+//  Created by Andreas Pohl on 19.10.26.
+//  Copyright © 2026 Andreas Pohl. All rights reserved.
+//
+
+#ifndef ReplayBuffer_hpp
+#define ReplayBuffer_hpp
+
+#include <stdio.h>
+
+#include <opencv2/opencv.hpp>
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+#include <libswscale/swscale.h>
+}
+
+using namespace std;
+using namespace cv;
+
+//keeps the last seconds of the zoomed output as encoded packets in memory
+//the packets live in a ring of slots, whose buffers are overwritten in place when the ring comes round
+//the window is measured in time, so frames dropped on the way do not make it longer
+//the ring grows, if the window holds more frames than expected, only the bytes of the packets are limited
+//saving only muxes the packets into a file, nothing is encoded again
+class ReplayBuffer {
+    
+public:
+    ReplayBuffer(int width, int height, double fps, int seconds);
+    ~ReplayBuffer();
+    
+    //timestamp: presentation time of the frame in seconds, from any origin
+    void push(const Mat &frame, double timestamp);
+    bool save(const string &fileName);
+    
+private:
+    struct Packet {
+        vector<uint8_t> data;
+        int64_t pts = 0;
+        bool key = false;
+    };
+    
+    int width, height;
+    double fps;
+    int seconds;
+    
+    AVCodecContext *encoder = nullptr;
+    SwsContext *swsContext = nullptr;
+    AVFrame *avFrame = nullptr;
+    AVPacket *avPacket = nullptr;
+    //timestamp of the first frame and pts of the last one, in encoder time base
+    double startTime = -1;
+    int64_t lastPts = -1;
+    
+    //ring of packets, oldest at first, count valid ones
+    vector<Packet> ring;
+    size_t first = 0;
+    size_t count = 0;
+    //bytes of the valid packets
+    size_t bytes = 0;
+    mutex ringMutex;
+    
+    bool openEncoder();
+    void store(AVPacket *packet);
+    void dropOldest();
+};
+
+#endif /* ReplayBuffer_hpp */
@@ -0,0 +1,280 @@
+//
+//  ResourceGovernor.cpp
+//  AVRecorderSwift
+//
+//  Created by Andreas Pohl on 19.10.26.
+//  Copyright © 2026 Andreas Pohl. All rights reserved.
+//
+
+#include "ResourceGovernor.hpp"
+
+#include <opencv2/opencv.hpp>
+
+#include <thread>
+#include <math.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+
+#include <dispatch/dispatch.h>
+
+//load and recording state are checked at most once per second
+const static double UPDATE_INTERVAL = 1.0;
+
+//share of the cores left to the motion processing while busy
+const static int BUSY_CORE_SHARE = 4;
+
+//while busy, process at most real time of the camera, so processing still keeps up with the recording
+const static double BUSY_FRAME_RATE = 25.0;
+
+//while busy, read and write at most 16 MB/s
+const static double BUSY_IO_BANDWIDTH = 16e6;
+
+//load of other processes per core, above which the machine counts as busy
+const static double LOAD_LIMIT = 0.75;
+
+//I/O may run ahead of the bandwidth by this many seconds before it is throttled
+const static double IO_BURST = 0.25;
+
+//updates closer than this are too short to measure the CPU use of this process
+const static double MIN_CPU_INTERVAL = 0.1;
+
+//getloadavg() averages over one minute, the CPU use of this process is averaged the same way to compare it
+const static double LOAD_AVERAGE_PERIOD = 60.0;
+
+struct ResourceGovernor::StripeJob {
+    void *context;
+    void (*work)(void *context, size_t index);
+    size_t stripes;
+    size_t count;
+};
+
+//user and system time of this process in seconds
+static double cpuTime() {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0.0;
+    }
+    return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 + usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+}
+
+ResourceGovernor &ResourceGovernor::shared() {
+    static ResourceGovernor governor;
+    return governor;
+}
+
+ResourceGovernor::ResourceGovernor() {
+    cores = MAX(1, (int) thread::hardware_concurrency());
+    busyWorkers = MAX(1, cores / BUSY_CORE_SHARE);
+    busyFrameRate = BUSY_FRAME_RATE;
+    busyIoBandwidth = BUSY_IO_BANDWIDTH;
+    workerLimit = cores;
+    lastFrame = chrono::steady_clock::now();
+    ioFree = lastFrame;
+    lastUpdate = lastFrame;
+    lastCpuTime = cpuTime();
+    lastCpuUpdate = lastFrame;
+}
+
+void ResourceGovernor::setRecording(bool on) {
+    {
+        lock_guard<mutex> guard(lock);
+        recording = on;
+    }
+    //back off at once, not only with the next update
+    update(true);
+}
+
+bool ResourceGovernor::isRecording() {
+    lock_guard<mutex> guard(lock);
+    return recording;
+}
+
+void ResourceGovernor::setBusyLimits(int workers, double frameRate, double ioBandwidth) {
+    {
+        lock_guard<mutex> guard(lock);
+        busyWorkers = workers > 0 ? workers : cores;
+        busyFrameRate = frameRate;
+        busyIoBandwidth = ioBandwidth;
+    }
+    update(true);
+}
+
+int ResourceGovernor::getWorkerLimit() {
+    update();
+    lock_guard<mutex> guard(lock);
+    return workerLimit;
+}
+
+//decide on the limits from the recording state and the load of the machine
+void ResourceGovernor::update(bool force) {
+    unique_lock<mutex> guard(lock);
+    
+    chrono::steady_clock::time_point now = chrono::steady_clock::now();
+    double elapsed = chrono::duration<double>(now - lastUpdate).count();
+    if (!force and elapsed < UPDATE_INTERVAL) {
+        return;
+    }
+    lastUpdate = now;
+    
+    //the cores this process used, damped like the load average
+    //so a job that just ended still counts as own load, as long as it is in the load average
+    double cpuElapsed = chrono::duration<double>(now - lastCpuUpdate).count();
+    if (cpuElapsed >= MIN_CPU_INTERVAL) {
+        double cpu = cpuTime();
+        double decay = exp(-cpuElapsed / LOAD_AVERAGE_PERIOD);
+        ownLoad = ownLoad * decay + (cpu - lastCpuTime) / cpuElapsed * (1 - decay);
+        lastCpuTime = cpu;
+        lastCpuUpdate = now;
+    }
+    
+    //the load average includes this process, only the rest is load of others
+    double load[1] = { 0.0 };
+    double otherLoad = 0.0;
+    if (getloadavg(load, 1) == 1) {
+        otherLoad = MAX(0.0, load[0] - ownLoad);
+    }
+    
+    busy = recording or otherLoad > LOAD_LIMIT * cores;
+    
+    //leave the cores used by others to them
+    int workers = cores - (int) ceil(otherLoad);
+    if (busy) {
+        workers = MIN(workers, busyWorkers);
+    }
+    workerLimit = MAX(1, MIN(cores, workers));
+}
+
+//OpenCV's own worker threads (resize, blur, cvtColor, ...), only called by the processing job between frames
+//resizing the thread pool while another thread is inside parallel_for_ is not safe, so it waits for a calm moment
+void ResourceGovernor::applyOpenCvThreads() {
+    lock_guard<mutex> guard(lock);
+    if (openCvUsers == 0 and openCvThreads != workerLimit) {
+        cv::setNumThreads(workerLimit);
+        openCvThreads = workerLimit;
+    }
+}
+
+ResourceGovernor::OpenCvScope::OpenCvScope() {
+    ResourceGovernor &governor = ResourceGovernor::shared();
+    lock_guard<mutex> guard(governor.lock);
+    governor.openCvUsers++;
+}
+
+ResourceGovernor::OpenCvScope::~OpenCvScope() {
+    ResourceGovernor &governor = ResourceGovernor::shared();
+    lock_guard<mutex> guard(governor.lock);
+    governor.openCvUsers--;
+}
+
+void ResourceGovernor::beginJob() {
+    update(true);
+    applyOpenCvThreads();
+    lock_guard<mutex> guard(lock);
+    report = Report();
+    report.minWorkers = workerLimit;
+    report.maxWorkers = workerLimit;
+    lastFrame = chrono::steady_clock::now();
+    ioFree = lastFrame;
+}
+
+ResourceGovernor::Report ResourceGovernor::endJob() {
+    //the processing thread is a shared GCD thread, so it must not stay throttled
+    setiopolicy_np(IOPOL_TYPE_DISK, IOPOL_SCOPE_THREAD, IOPOL_DEFAULT);
+    lock_guard<mutex> guard(lock);
+    return report;
+}
+
+void ResourceGovernor::sleep(double seconds, double &account) {
+    if (seconds <= 0) {
+        return;
+    }
+    this_thread::sleep_for(chrono::duration<double>(seconds));
+    lock_guard<mutex> guard(lock);
+    account += seconds;
+}
+
+void ResourceGovernor::frameDone() {
+    update();
+    applyOpenCvThreads();
+    
+    unique_lock<mutex> guard(lock);
+    report.frames++;
+    report.minWorkers = MIN(report.minWorkers, workerLimit);
+    report.maxWorkers = MAX(report.maxWorkers, workerLimit);
+    
+    chrono::steady_clock::time_point now = chrono::steady_clock::now();
+    double wait = 0.0;
+    if (busy) {
+        report.busyFrames++;
+        if (busyFrameRate > 0) {
+            wait = 1.0 / busyFrameRate - chrono::duration<double>(now - lastFrame).count();
+        }
+    }
+    if (wait > 0) {
+        report.throttleCount++;
+        lastFrame = now + chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(wait));
+    } else {
+        lastFrame = now;
+    }
+    bool throttleDisk = busy;
+    guard.unlock();
+    
+    //disk I/O of the processing thread gets throttled by the system whenever the recording needs the disk
+    setiopolicy_np(IOPOL_TYPE_DISK, IOPOL_SCOPE_THREAD, throttleDisk ? IOPOL_THROTTLE : IOPOL_DEFAULT);
+    
+    sleep(wait, report.frameRateSleep);
+}
+
+void ResourceGovernor::ioDone(double bytes) {
+    unique_lock<mutex> guard(lock);
+    report.ioBytes += bytes;
+    
+    chrono::steady_clock::time_point now = chrono::steady_clock::now();
+    if (!busy or busyIoBandwidth <= 0) {
+        ioFree = now;
+        return;
+    }
+    
+    //the bytes are due at ioFree, sleep if that is too far ahead
+    if (ioFree < now) {
+        ioFree = now;
+    }
+    ioFree += chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(bytes / busyIoBandwidth));
+    double wait = chrono::duration<double>(ioFree - now).count() - IO_BURST;
+    if (wait > 0) {
+        report.throttleCount++;
+    }
+    guard.unlock();
+    
+    sleep(wait, report.ioSleep);
+}
+
+void ResourceGovernor::runStripe(void *context, size_t stripe) {
+    StripeJob *job = (StripeJob *) context;
+    for (size_t i = stripe; i < job->count; i += job->stripes) {
+        job->work(job->context, i);
+    }
+}
+
+void ResourceGovernor::apply(size_t count, void *context, void (*work)(void *context, size_t index)) {
+    update();
+    
+    size_t stripes;
+    bool background;
+    {
+        lock_guard<mutex> guard(lock);
+        stripes = MIN((size_t) workerLimit, count);
+        background = busy;
+    }
+    
+    if (stripes <= 1) {
+        for (size_t i = 0; i < count; i++) {
+            work(context, i);
+        }
+        return;
+    }
+    
+    //background QoS also throttles the disk I/O of the workers
+    StripeJob job = { context, work, stripes, count };
+    dispatch_apply_f(stripes, dispatch_get_global_queue(background ? QOS_CLASS_BACKGROUND : QOS_CLASS_UTILITY, 0), &job, runStripe);
+}
@@ -0,0 +1,112 @@
+//
+//  ResourceGovernor.hpp
+//  AVRecorderSwift
+//
+//  Created by Andreas Pohl on 19.10.26.
+//  Copyright © 2026 Andreas Pohl. All rights reserved.
+//
+
+#ifndef ResourceGovernor_hpp
+#define ResourceGovernor_hpp
+
+#include <stdio.h>
+
+#include <chrono>
+#include <mutex>
+
+using namespace std;
+
+//keeps the motion processing from taking CPU and disk bandwidth away from the recording
+//full speed when the machine is idle, backing off while recording or when other processes load the machine
+//busy: worker threads capped, frame rate and I/O bandwidth limited, background QoS and throttled disk I/O
+//the worker cap covers apply(), OpenCV's thread pool and the decoder of the MotionVectorReader (when it is opened)
+//it does not cover the decoder threads of VideoCapture, OpenCV's FFmpeg backend chooses them itself
+class ResourceGovernor {
+
+public:
+    //how much was throttled since beginJob()
+    struct Report {
+        long frames = 0;
+        long throttleCount = 0; // how often the processing was delayed for the frame rate or the I/O bandwidth
+        double frameRateSleep = 0.0; // seconds slept to keep the frame rate
+        double ioSleep = 0.0; // seconds slept to keep the I/O bandwidth
+        double ioBytes = 0.0; // bytes read and written
+        long busyFrames = 0; // frames processed while recording or under load
+        int minWorkers = 0; // lowest worker thread cap
+        int maxWorkers = 0; // highest worker thread cap
+    };
+    
+    //one governor for the whole process, as the recording is shared as well
+    static ResourceGovernor &shared();
+    
+    //set by the app when a recording starts or stops
+    void setRecording(bool on);
+    bool isRecording();
+    
+    //limits while busy, 0 means unlimited. Frame rate in frames per second, I/O bandwidth in bytes per second
+    void setBusyLimits(int workers, double frameRate, double ioBandwidth);
+    
+    //one processing job, e.g. one movie. Resets the report
+    void beginJob();
+    Report endJob();
+    
+    //to be called by the processing thread once per frame, sleeps if the frame rate is too high
+    void frameDone();
+    //to be called by the processing thread after reading or writing, sleeps if the bandwidth is too high
+    void ioDone(double bytes);
+    
+    //runs work(context, i) for every i < count, on at most getWorkerLimit() threads
+    void apply(size_t count, void *context, void (*work)(void *context, size_t index));
+    
+    int getWorkerLimit();
+    
+    //OpenCV work outside the processing job, e.g. the live analysis on the capture queue
+    //OpenCV's thread pool is only resized while no such work is running
+    class OpenCvScope {
+    public:
+        OpenCvScope();
+        ~OpenCvScope();
+    };
+
+private:
+    ResourceGovernor();
+    
+    mutex lock;
+    
+    int cores;
+    bool recording = false;
+    
+    int busyWorkers;
+    double busyFrameRate;
+    double busyIoBandwidth;
+    
+    //actual state, updated at most every UPDATE_INTERVAL
+    bool busy = false;
+    int workerLimit;
+    chrono::steady_clock::time_point lastUpdate;
+    
+    //CPU time of this process at the last update, and the cores it used, averaged like the load average
+    double lastCpuTime;
+    chrono::steady_clock::time_point lastCpuUpdate;
+    double ownLoad = 0.0;
+    
+    //OpenCV work running outside the processing job, and the thread count OpenCV was given
+    int openCvUsers = 0;
+    int openCvThreads = 0;
+    
+    //pacing
+    chrono::steady_clock::time_point lastFrame;
+    chrono::steady_clock::time_point ioFree;
+    
+    Report report;
+    
+    void update(bool force = false);
+    void applyOpenCvThreads();
+    void sleep(double seconds, double &account);
+    
+    //stripes of an apply() job, one per worker
+    struct StripeJob;
+    static void runStripe(void *context, size_t stripe);
+};
+
+#endif /* ResourceGovernor_hpp */
@@ -14,9 +14,18 @@ class VideoProcessor: NSObject {
     
     var isRunning = true
     
+    //between full sweeps, only the regions around the tracked objects are analysed
+    let ROI_TRACKING = false
+    
+    //how a full sweep looks for motion: .full, .pyramid or .motionVectors (decodes with FFmpeg)
+    let SWEEP_MODE = MotionWrapperSweepMode.full
+    
     func run () {
         print("VideoProcessor started...")
         
+        MotionWrapper.setRoiTracking(ROI_TRACKING)
+        MotionWrapper.setSweepMode(SWEEP_MODE)
+        
         let fileManager = FileManager()
         
         //get path to movies directory
@@ -37,11 +46,17 @@ class VideoProcessor: NSObject {
                         let fromPathFileNameExtension = inPath.appendingPathComponent(file)
                         
                         //here comes the action: process the video
-                        MotionWrapper().processVideoWrapped(fromPathFileNameExtension)
+                        let areaCount = MotionWrapper().processVideoWrapped(fromPathFileNameExtension)
                         
-                        //as processing is done, lets merge the videos
+                        //as processing is done, lets merge the videos, every area on its own
                         let videoLabel : String = file.replacingOccurrences(of: " new.mov", with: "")
-                        VideoMerger().merge(videoLabel: videoLabel)
+                        if areaCount > 1 {
+                            for area in 1...areaCount {
+                                VideoMerger().merge(videoLabel: videoLabel + " area \(area)")
+                            }
+                        } else {
+                            VideoMerger().merge(videoLabel: videoLabel)
+                        }
                         
                         
                         //rename input file to "archive", so they get archived by FileHandler
@@ -193,6 +193,11 @@ class StateMachine : NSObject, ORSSerialPortDelegate {
                     appDelegate.stopRecording()
                 }
                 
+                if string.lowercased().hasPrefix("replay") {
+                    print("override replay")
+                    appDelegate.saveReplay()
+                }
+                
                 prompter.printPrompt()
             default:
                 break;
@@ -216,6 +221,11 @@ class StateMachine : NSObject, ORSSerialPortDelegate {
                 print("Aufnahme stoppen!")
                 appDelegate.stopRecording()
             }
+            
+            if string.contains("replay") {
+                print("Wiederholung speichern!")
+                appDelegate.saveReplay()
+            }
         }
     }
     
@@ -20,6 +20,35 @@ class MotionTest: XCTestCase {
     }
     
     func testMotion() {
+        MotionWrapper.setRoiTracking(false)
+        MotionWrapper().processVideoDebug(copyTestMovie(prefix: ""))
+    }
+    
+    //the same movie with ROI tracking, its debug movie in 7_debug is compared by eye with the one of testMotion
+    func testMotionRoiTracking() {
+        MotionWrapper.setRoiTracking(true)
+        MotionWrapper().processVideoDebug(copyTestMovie(prefix: "roi "))
+        MotionWrapper.setRoiTracking(false)
+    }
+    
+    //processing time of the sweep modes, without debug output, on an idle and on a busy movie
+    //motion vectors need their own decoder, they have to beat the pyramid on the mostly idle movies to be worth it
+    func testSweepModeSpeed() {
+        let modes : [(String, MotionWrapperSweepMode)] = [("full", .full), ("pyramid", .pyramid), ("vectors", .motionVectors)]
+        for movie in [7, 8] {
+            for (name, mode) in modes {
+                let tempName = copyTestMovie(prefix: name + " ", movie: movie)
+                MotionWrapper.setSweepMode(mode)
+                let start = Date()
+                MotionWrapper().processVideoWrapped(tempName)
+                print("movie \(movie), sweep mode \(name): \(String(format: "%.1f", Date().timeIntervalSince(start))) s")
+            }
+        }
+        MotionWrapper.setSweepMode(.full)
+    }
+    
+    //copies the test movie to temp, with the prefix in front of the name, returns the path of the copy
+    func copyTestMovie(prefix: String, movie: Int = 8) -> String {
         let testMovies = [
             1: "1 new.mov",
             2: "2 new.mov",
@@ -31,20 +60,130 @@ class MotionTest: XCTestCase {
             8: "fast new.mov"
         ]
         
-        let movieToTest = 8
+        let movieToTest = movie
         let movieName = testMovies[movieToTest]!
 
         let basePath = "/Users/andreas/Movies/AVRecorderTest/"
         let tempPath = basePath + "/temp/"
         let sourceName = basePath + movieName
-        let tempName = tempPath + movieName
+        let tempName = tempPath + prefix + movieName
         let fileManager = FileManager()
         do {
             try fileManager.copyItem(at: URL(fileURLWithPath: sourceName), to: URL(fileURLWithPath: tempName));
         } catch let moveError as NSError {
             print(moveError.localizedDescription)
         }
-        MotionWrapper().processVideoDebug(tempName)
+        return tempName
+    }
+    
+    //MARK: MotionEngine C interface, synthetic frames, no test movies needed
+    
+    let frameWidth : Int32 = 1920
+    let frameHeight : Int32 = 1080
+    let blockSize = 80
+    
+    //black gray frame with a white block at blockX, vertically centered, so it is in the band where objects are tracked
+    func makeFrame(blockX: Int) -> [UInt8] {
+        var frame = [UInt8](repeating: 0, count: Int(frameWidth * frameHeight))
+        let top = Int(frameHeight) / 2 - blockSize / 2
+        for y in top..<(top + blockSize) {
+            for x in blockX..<(blockX + blockSize) {
+                frame[y * Int(frameWidth) + x] = 255
+            }
+        }
+        return frame
+    }
+    
+    func processFrame(_ engine: MotionEngineRef, _ frame: [UInt8], _ result: inout MotionResult) -> Int32 {
+        return frame.withUnsafeBufferPointer { buffer in
+            MotionEngineProcessFrame(engine, buffer.baseAddress, frameWidth, frameHeight, Int(frameWidth), MotionPixelFormatGray, &result)
+        }
+    }
+    
+    //the valid tracked objects of a result, the C array comes as a tuple
+    func trackedObjects(_ result: MotionResult) -> [MotionPoint] {
+        var objects = result.objects
+        return withUnsafeBytes(of: &objects) { Array($0.bindMemory(to: MotionPoint.self).prefix(Int(result.objectCount))) }
+    }
+    
+    func testEngineRejectsInvalidInput() {
+        XCTAssertNil(MotionEngineCreate(0, frameHeight))
+        
+        let engine = MotionEngineCreate(frameWidth, frameHeight)
+        XCTAssertNotNil(engine)
+        defer { MotionEngineRelease(engine) }
+        
+        var result = MotionResult()
+        let frame = makeFrame(blockX: 0)
+        
+        //size mismatch
+        frame.withUnsafeBufferPointer { buffer in
+            XCTAssertEqual(MotionEngineProcessFrame(engine, buffer.baseAddress, frameWidth / 2, frameHeight / 2, Int(frameWidth), MotionPixelFormatGray, &result), -1)
+        }
+        
+        //no engine, no data, no result
+        frame.withUnsafeBufferPointer { buffer in
+            XCTAssertEqual(MotionEngineProcessFrame(nil, buffer.baseAddress, frameWidth, frameHeight, Int(frameWidth), MotionPixelFormatGray, &result), -1)
+            XCTAssertEqual(MotionEngineProcessFrame(engine, buffer.baseAddress, frameWidth, frameHeight, Int(frameWidth), MotionPixelFormatGray, nil), -1)
+        }
+        XCTAssertEqual(MotionEngineProcessFrame(engine, nil, frameWidth, frameHeight, Int(frameWidth), MotionPixelFormatGray, &result), -1)
+        XCTAssertEqual(MotionEngineSetMask(nil, nil, 0, 0, 0), -1)
+        
+        //a valid frame still works afterwards
+        XCTAssertEqual(processFrame(engine!, frame, &result), 0)
+    }
+    
+    func testEngineCalmSceneShowsWholeFrame() {
+        let engine = MotionEngineCreate(frameWidth, frameHeight)!
+        defer { MotionEngineRelease(engine) }
+        
+        var result = MotionResult()
+        let frame = makeFrame(blockX: 400)
+        for _ in 0..<10 {
+            XCTAssertEqual(processFrame(engine, frame, &result), 0)
+        }
+        
+        XCTAssertEqual(result.crop.x, 0)
+        XCTAssertEqual(result.crop.y, 0)
+        XCTAssertEqual(result.crop.width, frameWidth)
+        XCTAssertEqual(result.crop.height, frameHeight)
+        XCTAssertEqual(result.objectCount, 0)
+    }
+    
+    func testEngineFollowsMovingBlock() {
+        let engine = MotionEngineCreate(frameWidth, frameHeight)!
+        defer { MotionEngineRelease(engine) }
+        
+        //8 pixels per frame to the right, long enough for the objects to become mature
+        var result = MotionResult()
+        var blockX = 400
+        for _ in 0..<40 {
+            XCTAssertEqual(processFrame(engine, makeFrame(blockX: blockX), &result), 0)
+            blockX += 8
+        }
+        blockX -= 8
+        
+        //the motion is found around the block, not all over the frame
+        let bounds = result.boundingRectangle
+        XCTAssertLessThan(Int(bounds.x), blockX + blockSize)
+        XCTAssertGreaterThan(Int(bounds.x + bounds.width), blockX)
+        XCTAssertLessThan(bounds.width, frameWidth / 4)
+        
+        //the block is tracked as an object
+        let objects = trackedObjects(result)
+        XCTAssertGreaterThan(objects.count, 0)
+        let blockCenterX = Float(blockX + blockSize / 2)
+        let blockCenterY = Float(frameHeight) / 2
+        XCTAssertTrue(objects.contains { abs($0.x - blockCenterX) < 100 && abs($0.y - blockCenterY) < 100 })
+        
+        //the crop stays in the frame and shows the block
+        let crop = result.crop
+        XCTAssertGreaterThanOrEqual(crop.x, 0)
+        XCTAssertGreaterThanOrEqual(crop.y, 0)
+        XCTAssertLessThanOrEqual(crop.x + crop.width, frameWidth)
+        XCTAssertLessThanOrEqual(crop.y + crop.height, frameHeight)
+        XCTAssertLessThanOrEqual(Int(crop.x), blockX)
+        XCTAssertGreaterThanOrEqual(Int(crop.x + crop.width), blockX + blockSize)
     }
     
     func testExample() {
@@ -0,0 +1,79 @@
+//
+//  ObjectHandlerTest.mm
+//  MotionTest
+//
+//  Created by Andreas Pohl on 19.10.26.
+//  Copyright © 2026 Andreas Pohl. All rights reserved.
+//
+
+//OpenCV has to come before the Apple headers, its stitching module clashes with the NO macro
+#include "ObjectHandler.hpp"
+#import <XCTest/XCTest.h>
+
+//the prediction of the next object positions, fed with cluster centers directly
+@interface ObjectHandlerTest : XCTestCase
+@end
+
+@implementation ObjectHandlerTest
+
+//one cluster center per frame, in the band of the image where objects are tracked
+static void updateWithCenter(ObjectHandler &handler, Point2f center) {
+    Mat centers(1, 1, CV_32FC2);
+    centers.at<Point2f>(0) = center;
+    handler.update(centers);
+}
+
+- (void)testPredictRegionsFollowsVelocity {
+    ObjectHandler handler(960, 540);
+    
+    //10 pixels per frame to the right, long enough for the object to become mature and its velocity to settle
+    for (int i = 0; i < 30; i++) {
+        updateWithCenter(handler, Point2f(200 + 10 * i, 270));
+    }
+    
+    vector<bool> moving;
+    vector<Rect> regions = handler.predictRegions(120, &moving);
+    XCTAssertEqual(regions.size(), (size_t) 1);
+    XCTAssertEqual(moving.size(), (size_t) 1);
+    if (regions.size() != 1 or moving.size() != 1) {
+        return;
+    }
+    XCTAssertTrue(moving[0]);
+    
+    //centered on the next position (490 + 10), enlarged by the velocity in x only
+    Rect region = regions[0];
+    XCTAssertEqualWithAccuracy(region.x + region.width / 2.0, 500.0, 2.0);
+    XCTAssertEqualWithAccuracy(region.y + region.height / 2.0, 270.0, 2.0);
+    XCTAssertEqualWithAccuracy(region.width, 2 * (120 + 10), 4);
+    XCTAssertEqual(region.height, 2 * 120);
+}
+
+- (void)testPredictRegionsStandingObject {
+    ObjectHandler handler(960, 540);
+    
+    for (int i = 0; i < 30; i++) {
+        updateWithCenter(handler, Point2f(400, 270));
+    }
+    
+    vector<bool> moving;
+    vector<Rect> regions = handler.predictRegions(120, &moving);
+    XCTAssertEqual(regions.size(), (size_t) 1);
+    XCTAssertEqual(moving.size(), (size_t) 1);
+    if (regions.size() != 1 or moving.size() != 1) {
+        return;
+    }
+    
+    //a standing object cannot lose its target, so it must not count as moving
+    XCTAssertFalse(moving[0]);
+    XCTAssertTrue(regions[0] == Rect(400 - 120, 270 - 120, 240, 240));
+}
+
+- (void)testPredictRegionsIgnoresYoungObjects {
+    ObjectHandler handler(960, 540);
+    
+    updateWithCenter(handler, Point2f(400, 270));
+    
+    XCTAssertTrue(handler.predictRegions(120).empty());
+}
+
+@end